@@ -34,6 +34,25 @@ Andreas Schiffler -- aschiffler at ferzkopp dot net
 
 #include "SDL2_gfxPrimitives.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define GFX_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+/* AVX2 needs -mavx2 or /arch:AVX2 on this file (VORONOI_AVX2 in CMakeLists.txt) */
+#if defined(__AVX2__)
+#define GFX_SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+/* Storage class of the per-thread scratch arrays */
+#if defined(_MSC_VER)
+#define GFX_THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+#define GFX_THREAD_LOCAL _Thread_local
+#else
+#define GFX_THREAD_LOCAL __thread
+#endif
+
 /* ---- Structures */
 
 /*!
@@ -48,14 +67,771 @@ typedef struct {
 /*!
 \brief The structure passed to the internal Murphy iterator.
 */
-typedef struct {
-	SDL_Renderer *renderer;
-	int u, v;		/* delta x , delta y */
-	int ku, kt, kv, kd;	/* loop constants */
-	int oct2;
-	int quad4;
-	Sint16 last1x, last1y, last2x, last2y, first1x, first1y, first2x, first2y, tempx, tempy;
-} SDL2_gfxMurphyIterator;
+typedef struct {
+	SDL_Renderer *renderer;
+	int u, v;		/* delta x , delta y */
+	int ku, kt, kv, kd;	/* loop constants */
+	int oct2;
+	int quad4;
+	Sint16 last1x, last1y, last2x, last2y, first1x, first1y, first2x, first2y, tempx, tempy;
+} SDL2_gfxMurphyIterator;
+
+/* ---- Batch */
+
+/*!
+\brief Per-thread batch of the one-shot drawing functions, kept off the stack.
+
+Only used between a gfxBatchBegin and gfxBatchEnd inside one function, which
+never calls another function using it.
+*/
+static GFX_THREAD_LOCAL SDL2_gfxBatch gfxPrimitivesBatchThread;
+
+/*!
+\brief Start a batch of spans and points drawn in one color.
+
+\param batch The batch to initialize, usually on the stack.
+\param renderer The renderer to draw on.
+\param r The red value of the batch color.
+\param g The green value of the batch color.
+\param b The blue value of the batch color.
+\param a The alpha value of the batch color.
+*/
+void gfxBatchBegin(SDL2_gfxBatch * batch, SDL_Renderer * renderer, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+	batch->renderer = renderer;
+	batch->surface = NULL;
+	batch->format = NULL;
+	batch->pixels = NULL;
+	batch->pitch = 0;
+	batch->r = r;
+	batch->g = g;
+	batch->b = b;
+	batch->a = a;
+	batch->rects = 0;
+	batch->points = 0;
+	batch->weights = 0;
+	batch->result = 0;
+	batch->weightVertices = NULL;
+	batch->weightIndices = NULL;
+	batch->weightCapacity = 0;
+}
+
+/*!
+\brief Start a batch drawing into a 32-bit surface instead of a renderer.
+
+The surface is locked until gfxBatchEnd and drawing is clipped to its clip rectangle.
+
+\param batch The batch to initialize, usually on the stack.
+\param surface The surface to draw on; must have 4 bytes per pixel.
+\param r The red value of the batch color.
+\param g The green value of the batch color.
+\param b The blue value of the batch color.
+\param a The alpha value of the batch color.
+
+\returns Returns 0 on success, -1 if the surface cannot be drawn on.
+*/
+int gfxBatchBeginSurface(SDL2_gfxBatch * batch, SDL_Surface * surface, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+	gfxBatchBegin(batch, NULL, r, g, b, a);
+	if (surface->format->BytesPerPixel != 4) {
+		batch->result = SDL_SetError("gfxBatchBeginSurface: surface must have 32 bits per pixel");
+		return -1;
+	}
+	if (SDL_MUSTLOCK(surface) && (SDL_LockSurface(surface) != 0)) {
+		batch->result = -1;
+		return -1;
+	}
+	batch->surface = surface;
+	batch->format = surface->format;
+	batch->pixels = (Uint32 *) surface->pixels;
+	batch->pitch = surface->pitch / 4;
+	batch->bounds = surface->clip_rect;
+	batch->clip = batch->bounds;
+	return 0;
+}
+
+/*!
+\brief Start a batch drawing into a raw ARGB8888 framebuffer.
+
+\param batch The batch to initialize, usually on the stack.
+\param pixels The first pixel of the framebuffer.
+\param width The width of the framebuffer in pixels.
+\param height The height of the framebuffer in pixels.
+\param pitch The distance between two rows, in pixels.
+\param r The red value of the batch color.
+\param g The green value of the batch color.
+\param b The blue value of the batch color.
+\param a The alpha value of the batch color.
+*/
+void gfxBatchBeginPixels(SDL2_gfxBatch * batch, Uint32 * pixels, int width, int height, int pitch, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+	gfxBatchBegin(batch, NULL, r, g, b, a);
+	batch->pixels = pixels;
+	batch->pitch = pitch;
+	batch->bounds.x = 0;
+	batch->bounds.y = 0;
+	batch->bounds.w = width;
+	batch->bounds.h = height;
+	batch->clip = batch->bounds;
+}
+
+/*!
+\brief Restrict the drawing of a software batch to a rectangle.
+
+Pending primitives are flushed first. Primitives are only rasterized where they
+meet the rectangle, so several batches clipped to disjoint tiles can draw the same
+primitives into one framebuffer from different threads.
+
+\param batch The batch to draw with.
+\param rect The rectangle to draw in, intersected with the target; NULL for the whole target.
+*/
+void gfxBatchSetClip(SDL2_gfxBatch * batch, const SDL_Rect * rect)
+{
+	int x1, y1, x2, y2;
+
+	gfxBatchFlush(batch);
+	batch->clip = batch->bounds;
+	if (rect == NULL) {
+		return;
+	}
+	x1 = (rect->x > batch->bounds.x) ? rect->x : batch->bounds.x;
+	y1 = (rect->y > batch->bounds.y) ? rect->y : batch->bounds.y;
+	x2 = (rect->x + rect->w < batch->bounds.x + batch->bounds.w) ? rect->x + rect->w : batch->bounds.x + batch->bounds.w;
+	y2 = (rect->y + rect->h < batch->bounds.y + batch->bounds.h) ? rect->y + rect->h : batch->bounds.y + batch->bounds.h;
+	batch->clip.x = x1;
+	batch->clip.y = y1;
+	batch->clip.w = (x2 > x1) ? x2 - x1 : 0;
+	batch->clip.h = (y2 > y1) ? y2 - y1 : 0;
+}
+
+/*!
+\brief Internal span kernel writing w copies of an opaque color.
+
+\param p The first pixel of the span.
+\param w The number of pixels of the span.
+\param color The color, in the pixel format of the target.
+*/
+static void _gfxSpanFill(Uint32 * p, int w, Uint32 color)
+{
+	int i = 0;
+#ifdef GFX_SIMD_AVX2
+	__m256i c8 = _mm256_set1_epi32((int) color);
+#endif
+#ifdef GFX_SIMD_SSE2
+	__m128i c4 = _mm_set1_epi32((int) color);
+#endif
+
+#ifdef GFX_SIMD_AVX2
+	for (; i + 8 <= w; i += 8) {
+		_mm256_storeu_si256((__m256i *) (p + i), c8);
+	}
+#endif
+#ifdef GFX_SIMD_SSE2
+	for (; i + 4 <= w; i += 4) {
+		_mm_storeu_si128((__m128i *) (p + i), c4);
+	}
+#endif
+	for (; i < w; i++) {
+		p[i] = color;
+	}
+}
+
+/*!
+\brief Internal function blending a color over one pixel, bytewise.
+
+\param pixel The pixel to blend over.
+\param color The color with an opaque alpha byte, in the pixel format of the target.
+\param a The alpha value to blend with.
+
+\returns Returns the blended pixel.
+*/
+static Uint32 _gfxBlend(Uint32 pixel, Uint32 color, Uint32 a)
+{
+	int k;
+	Uint32 t, out;
+
+	out = 0;
+	for (k = 0; k < 32; k += 8) {
+		t = ((color >> k) & 0xff) * a + ((pixel >> k) & 0xff) * (255 - a) + 128;
+		out |= ((t + (t >> 8)) >> 8) << k;
+	}
+	return out;
+}
+
+/*!
+\brief Internal span kernel blending a color over w pixels.
+
+Every byte of the pixel becomes round((color * a + pixel * (255 - a)) / 255); with the
+alpha byte of the color at 255 this is SDL_BLENDMODE_BLEND for any 32-bit format.
+
+\param p The first pixel of the span.
+\param w The number of pixels of the span.
+\param color The color with an opaque alpha byte, in the pixel format of the target.
+\param a The alpha value to blend with.
+*/
+static void _gfxSpanBlend(Uint32 * p, int w, Uint32 color, Uint8 a)
+{
+	int i = 0;
+#ifdef GFX_SIMD_AVX2
+	__m256i zero8 = _mm256_setzero_si256();
+	__m256i sa8 = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(_mm256_set1_epi32((int) color), zero8), _mm256_set1_epi16(a)), _mm256_set1_epi16(128));
+	__m256i ia8 = _mm256_set1_epi16(255 - a);
+	__m256i d8, lo8, hi8;
+#endif
+#ifdef GFX_SIMD_SSE2
+	__m128i zero4 = _mm_setzero_si128();
+	__m128i sa4 = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32((int) color), zero4), _mm_set1_epi16(a)), _mm_set1_epi16(128));
+	__m128i ia4 = _mm_set1_epi16(255 - a);
+	__m128i d4, lo4, hi4;
+#endif
+
+	/* Blend 8 then 4 pixels at a time, two pixels per 16-bit register half */
+#ifdef GFX_SIMD_AVX2
+	for (; i + 8 <= w; i += 8) {
+		d8 = _mm256_loadu_si256((const __m256i *) (p + i));
+		lo8 = _mm256_add_epi16(sa8, _mm256_mullo_epi16(_mm256_unpacklo_epi8(d8, zero8), ia8));
+		hi8 = _mm256_add_epi16(sa8, _mm256_mullo_epi16(_mm256_unpackhi_epi8(d8, zero8), ia8));
+		lo8 = _mm256_srli_epi16(_mm256_add_epi16(lo8, _mm256_srli_epi16(lo8, 8)), 8);
+		hi8 = _mm256_srli_epi16(_mm256_add_epi16(hi8, _mm256_srli_epi16(hi8, 8)), 8);
+		_mm256_storeu_si256((__m256i *) (p + i), _mm256_packus_epi16(lo8, hi8));
+	}
+#endif
+#ifdef GFX_SIMD_SSE2
+	for (; i + 4 <= w; i += 4) {
+		d4 = _mm_loadu_si128((const __m128i *) (p + i));
+		lo4 = _mm_add_epi16(sa4, _mm_mullo_epi16(_mm_unpacklo_epi8(d4, zero4), ia4));
+		hi4 = _mm_add_epi16(sa4, _mm_mullo_epi16(_mm_unpackhi_epi8(d4, zero4), ia4));
+		lo4 = _mm_srli_epi16(_mm_add_epi16(lo4, _mm_srli_epi16(lo4, 8)), 8);
+		hi4 = _mm_srli_epi16(_mm_add_epi16(hi4, _mm_srli_epi16(hi4, 8)), 8);
+		_mm_storeu_si128((__m128i *) (p + i), _mm_packus_epi16(lo4, hi4));
+	}
+#endif
+
+	for (; i < w; i++) {
+		p[i] = _gfxBlend(p[i], color, a);
+	}
+}
+
+/*!
+\brief Internal function drawing the pending spans and points into the pixels of a software batch.
+
+\param batch The batch to flush.
+*/
+static void _gfxBatchFlushPixels(SDL2_gfxBatch * batch)
+{
+	int i, y;
+	int x1, y1, x2, y2;
+	Uint32 color, alpha;
+	Uint32 *row;
+	SDL_Rect *rect;
+	SDL_Point *point;
+
+	if (batch->a == 0) {
+		return;
+	}
+	if (batch->format != NULL) {
+		color = SDL_MapRGBA(batch->format, batch->r, batch->g, batch->b, 255);
+	} else {
+		color = 0xff000000 | ((Uint32) batch->r << 16) | ((Uint32) batch->g << 8) | (Uint32) batch->b;
+	}
+
+	for (i = 0; i < batch->rects; i++) {
+		rect = &batch->rect[i];
+		x1 = (rect->x > batch->clip.x) ? rect->x : batch->clip.x;
+		y1 = (rect->y > batch->clip.y) ? rect->y : batch->clip.y;
+		x2 = (rect->x + rect->w < batch->clip.x + batch->clip.w) ? rect->x + rect->w : batch->clip.x + batch->clip.w;
+		y2 = (rect->y + rect->h < batch->clip.y + batch->clip.h) ? rect->y + rect->h : batch->clip.y + batch->clip.h;
+		if ((x1 >= x2) || (y1 >= y2)) {
+			continue;
+		}
+		row = batch->pixels + y1 * batch->pitch + x1;
+		for (y = y1; y < y2; y++) {
+			if (batch->a == 255) {
+				_gfxSpanFill(row, x2 - x1, color);
+			} else {
+				_gfxSpanBlend(row, x2 - x1, color, batch->a);
+			}
+			row += batch->pitch;
+		}
+	}
+
+	for (i = 0; i < batch->points; i++) {
+		point = &batch->point[i];
+		if ((point->x < batch->clip.x) || (point->x >= batch->clip.x + batch->clip.w) ||
+			(point->y < batch->clip.y) || (point->y >= batch->clip.y + batch->clip.h)) {
+			continue;
+		}
+		row = batch->pixels + point->y * batch->pitch + point->x;
+		if (batch->a == 255) {
+			*row = color;
+		} else {
+			*row = _gfxBlend(*row, color, batch->a);
+		}
+	}
+
+	for (i = 0; i < batch->weights; i++) {
+		x1 = batch->weightX[i];
+		y1 = batch->weightY[i];
+		if ((x1 < batch->clip.x) || (x1 >= batch->clip.x + batch->clip.w) ||
+			(y1 < batch->clip.y) || (y1 >= batch->clip.y + batch->clip.h)) {
+			continue;
+		}
+		alpha = ((Uint32) batch->a * batch->weight[i]) >> 8;
+		if (alpha > 0) {
+			row = batch->pixels + y1 * batch->pitch + x1;
+			*row = _gfxBlend(*row, color, alpha);
+		}
+	}
+}
+
+/*!
+\brief Internal function submitting the weighted pixels of a batch as one SDL_RenderGeometry call.
+
+Every pixel is a quad in the batch color, with its alpha scaled by the pixel weight.
+The vertices and indices are kept in the batch, grown on demand up to
+SDL2_GFX_BATCH_SIZE pixels and released by gfxBatchEnd.
+
+\param batch The batch to flush.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+static int _gfxBatchFlushWeights(SDL2_gfxBatch * batch)
+{
+	int i;
+	int result;
+	int capacity;
+	float x, y;
+	SDL_Vertex *v;
+	SDL_Color color;
+	int *index;
+
+	if (batch->weights > batch->weightCapacity) {
+		capacity = 2 * batch->weightCapacity;
+		if (capacity < batch->weights) {
+			capacity = batch->weights;
+		}
+		if (capacity > SDL2_GFX_BATCH_SIZE) {
+			capacity = SDL2_GFX_BATCH_SIZE;
+		}
+		v = (SDL_Vertex *) realloc(batch->weightVertices, sizeof(SDL_Vertex) * 4 * capacity);
+		if (v != NULL) {
+			batch->weightVertices = v;
+		}
+		index = (int *) realloc(batch->weightIndices, sizeof(int) * 6 * capacity);
+		if (index != NULL) {
+			batch->weightIndices = index;
+		}
+		if ((v == NULL) || (index == NULL)) {
+			return -1;
+		}
+		for (i = batch->weightCapacity; i < capacity; i++) {
+			index = &batch->weightIndices[6 * i];
+			index[0] = 4 * i;
+			index[1] = 4 * i + 1;
+			index[2] = 4 * i + 2;
+			index[3] = 4 * i + 2;
+			index[4] = 4 * i + 1;
+			index[5] = 4 * i + 3;
+		}
+		batch->weightCapacity = capacity;
+	}
+
+	color.r = batch->r;
+	color.g = batch->g;
+	color.b = batch->b;
+	for (i = 0; i < batch->weights; i++) {
+		x = batch->weightX[i];
+		y = batch->weightY[i];
+		color.a = (Uint8) (((Uint32) batch->a * batch->weight[i]) >> 8);
+		v = &batch->weightVertices[4 * i];
+		v[0].position.x = x;
+		v[0].position.y = y;
+		v[1].position.x = x + 1;
+		v[1].position.y = y;
+		v[2].position.x = x;
+		v[2].position.y = y + 1;
+		v[3].position.x = x + 1;
+		v[3].position.y = y + 1;
+		v[0].color = v[1].color = v[2].color = v[3].color = color;
+		v[0].tex_coord.x = v[0].tex_coord.y = 0;
+		v[1].tex_coord = v[2].tex_coord = v[3].tex_coord = v[0].tex_coord;
+	}
+
+	result = SDL_SetRenderDrawBlendMode(batch->renderer, SDL_BLENDMODE_BLEND);
+	result |= SDL_RenderGeometry(batch->renderer, NULL, batch->weightVertices, 4 * batch->weights,
+		batch->weightIndices, 6 * batch->weights);
+	return result;
+}
+
+/*!
+\brief Submit the pending spans and points, setting color and blend mode once.
+
+\param batch The batch to flush.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int gfxBatchFlush(SDL2_gfxBatch * batch)
+{
+	int result;
+
+	if ((batch->rects == 0) && (batch->points == 0) && (batch->weights == 0)) {
+		return 0;
+	}
+
+	if (batch->pixels != NULL) {
+		_gfxBatchFlushPixels(batch);
+		batch->rects = 0;
+		batch->points = 0;
+		batch->weights = 0;
+		return 0;
+	}
+	if (batch->renderer == NULL) {
+		batch->rects = 0;
+		batch->points = 0;
+		batch->weights = 0;
+		batch->result = -1;
+		return -1;
+	}
+
+	result = 0;
+	result |= SDL_SetRenderDrawBlendMode(batch->renderer, (batch->a == 255) ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
+	result |= SDL_SetRenderDrawColor(batch->renderer, batch->r, batch->g, batch->b, batch->a);
+	if (batch->rects > 0) {
+		result |= SDL_RenderFillRects(batch->renderer, batch->rect, batch->rects);
+	}
+	if (batch->points > 0) {
+		result |= SDL_RenderDrawPoints(batch->renderer, batch->point, batch->points);
+	}
+	if (batch->weights > 0) {
+		result |= _gfxBatchFlushWeights(batch);
+	}
+	batch->rects = 0;
+	batch->points = 0;
+	batch->weights = 0;
+	batch->result |= result;
+	return result;
+}
+
+/*!
+\brief Change the color of the following primitives, flushing the pending ones.
+
+\param batch The batch to draw with.
+\param r The red value of the new color.
+\param g The green value of the new color.
+\param b The blue value of the new color.
+\param a The alpha value of the new color.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int gfxBatchColor(SDL2_gfxBatch * batch, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+	int result = 0;
+
+	if ((batch->r != r) || (batch->g != g) || (batch->b != b) || (batch->a != a)) {
+		result = gfxBatchFlush(batch);
+		batch->r = r;
+		batch->g = g;
+		batch->b = b;
+		batch->a = a;
+	}
+	return result;
+}
+
+/*!
+\brief Flush the batch, unlocking its surface if it draws on one and releasing its buffers.
+
+Every gfxBatchBegin must be matched by a gfxBatchEnd.
+
+\param batch The batch to finish.
+
+\returns Returns 0 if every submission of the batch succeeded, -1 otherwise.
+*/
+int gfxBatchEnd(SDL2_gfxBatch * batch)
+{
+	gfxBatchFlush(batch);
+	if ((batch->surface != NULL) && SDL_MUSTLOCK(batch->surface)) {
+		SDL_UnlockSurface(batch->surface);
+	}
+	batch->surface = NULL;
+	batch->pixels = NULL;
+	free(batch->weightVertices);
+	batch->weightVertices = NULL;
+	free(batch->weightIndices);
+	batch->weightIndices = NULL;
+	batch->weightCapacity = 0;
+	return batch->result;
+}
+
+/*!
+\brief Internal helper appending a filled rectangle to a batch.
+
+\param batch The batch to draw with.
+\param x X coordinate of the left of the rectangle.
+\param y Y coordinate of the top of the rectangle.
+\param w Width of the rectangle.
+\param h Height of the rectangle.
+
+\returns Returns 0.
+*/
+static int _gfxBatchRect(SDL2_gfxBatch * batch, int x, int y, int w, int h)
+{
+	SDL_Rect *rect;
+
+	if ((batch->pixels != NULL) &&
+		((x >= batch->clip.x + batch->clip.w) || (x + w <= batch->clip.x) ||
+		(y >= batch->clip.y + batch->clip.h) || (y + h <= batch->clip.y))) {
+		return 0;
+	}
+	if (batch->rects == SDL2_GFX_BATCH_SIZE) {
+		gfxBatchFlush(batch);
+	}
+	rect = &batch->rect[batch->rects++];
+	rect->x = x;
+	rect->y = y;
+	rect->w = w;
+	rect->h = h;
+	return 0;
+}
+
+/*!
+\brief Append a pixel to a batch.
+
+\param batch The batch to draw with.
+\param x X (horizontal) coordinate of the pixel.
+\param y Y (vertical) coordinate of the pixel.
+
+\returns Returns 0.
+*/
+int pixelBatch(SDL2_gfxBatch * batch, Sint16 x, Sint16 y)
+{
+	if (batch->points == SDL2_GFX_BATCH_SIZE) {
+		gfxBatchFlush(batch);
+	}
+	batch->point[batch->points].x = x;
+	batch->point[batch->points].y = y;
+	batch->points++;
+	return 0;
+}
+
+/*!
+\brief Append a pixel whose alpha is scaled by a weight to a batch.
+
+The alpha of the pixel is (a * weight) >> 8, as with pixelRGBAWeight.
+
+\param batch The batch to draw with.
+\param x X (horizontal) coordinate of the pixel.
+\param y Y (vertical) coordinate of the pixel.
+\param weight The weight multiplied into the alpha value of the batch.
+
+\returns Returns 0.
+*/
+int pixelWeightBatch(SDL2_gfxBatch * batch, Sint16 x, Sint16 y, Uint8 weight)
+{
+	if (batch->weights == SDL2_GFX_BATCH_SIZE) {
+		gfxBatchFlush(batch);
+	}
+	batch->weightX[batch->weights] = x;
+	batch->weightY[batch->weights] = y;
+	batch->weight[batch->weights] = weight;
+	batch->weights++;
+	return 0;
+}
+
+/*!
+\brief Append a horizontal line to a batch.
+
+\param batch The batch to draw with.
+\param x1 X coordinate of the first point (i.e. left) of the line.
+\param x2 X coordinate of the second point (i.e. right) of the line.
+\param y Y coordinate of the points of the line.
+
+\returns Returns 0.
+*/
+int hlineBatch(SDL2_gfxBatch * batch, Sint16 x1, Sint16 x2, Sint16 y)
+{
+	if (x1 > x2) {
+		return _gfxBatchRect(batch, x2, y, x1 - x2 + 1, 1);
+	}
+	return _gfxBatchRect(batch, x1, y, x2 - x1 + 1, 1);
+}
+
+/*!
+\brief Append a vertical line to a batch.
+
+\param batch The batch to draw with.
+\param x X coordinate of the points of the line.
+\param y1 Y coordinate of the first point (i.e. top) of the line.
+\param y2 Y coordinate of the second point (i.e. bottom) of the line.
+
+\returns Returns 0.
+*/
+int vlineBatch(SDL2_gfxBatch * batch, Sint16 x, Sint16 y1, Sint16 y2)
+{
+	if (y1 > y2) {
+		return _gfxBatchRect(batch, x, y2, 1, y1 - y2 + 1);
+	}
+	return _gfxBatchRect(batch, x, y1, 1, y2 - y1 + 1);
+}
+
+/*!
+\brief Append a box (filled rectangle) to a batch.
+
+\param batch The batch to draw with.
+\param x1 X coordinate of the first point (i.e. top right) of the box.
+\param y1 Y coordinate of the first point (i.e. top right) of the box.
+\param x2 X coordinate of the second point (i.e. bottom left) of the box.
+\param y2 Y coordinate of the second point (i.e. bottom left) of the box.
+
+\returns Returns 0.
+*/
+int boxBatch(SDL2_gfxBatch * batch, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2)
+{
+	Sint16 tmp;
+
+	if (x1 > x2) {
+		tmp = x1;
+		x1 = x2;
+		x2 = tmp;
+	}
+	if (y1 > y2) {
+		tmp = y1;
+		y1 = y2;
+		y2 = tmp;
+	}
+	return _gfxBatchRect(batch, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+}
+
+/*!
+\brief Append a line to a batch, as horizontal or vertical runs of pixels.
+
+The pixel of the line at each column (or row, for steep lines) is the one nearest
+to the exact line, computed from the endpoints alone. Software batches only walk
+the columns of their clip rectangle, and a line split across several clipped
+batches is drawn with the same pixels as in one piece.
+
+SDL_RenderDrawLine does not specify its rasterization, which varies between
+renderer backends, so some pixels may differ from it where the line is exactly
+halfway between two rows or columns. lineRGBA keeps drawing with
+SDL_RenderDrawLine; use lineBatch where the same pixels are needed on every
+target.
+
+\param batch The batch to draw with.
+\param x1 X coordinate of the first point of the line.
+\param y1 Y coordinate of the first point of the line.
+\param x2 X coordinate of the second point of the line.
+\param y2 Y coordinate of the second point of the line.
+
+\returns Returns 0.
+*/
+int lineBatch(SDL2_gfxBatch * batch, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2)
+{
+	int steep;
+	int u1, v1, u2, v2, tmp;
+	int du, dv, step;
+	int u, ustart, uend, run;
+	int v, rem;
+	int lo, hi;
+	Sint64 num;
+
+	/*
+	* Walk along the major axis u; v is the minor axis
+	*/
+	steep = abs(y2 - y1) > abs(x2 - x1);
+	if (steep) {
+		u1 = y1; v1 = x1; u2 = y2; v2 = x2;
+	} else {
+		u1 = x1; v1 = y1; u2 = x2; v2 = y2;
+	}
+	if (u1 > u2) {
+		tmp = u1; u1 = u2; u2 = tmp;
+		tmp = v1; v1 = v2; v2 = tmp;
+	}
+	du = u2 - u1;
+	dv = v2 - v1;
+	if (du == 0) {
+		return pixelBatch(batch, x1, y1);
+	}
+
+	ustart = u1;
+	uend = u2;
+	if (batch->pixels != NULL) {
+		lo = steep ? batch->clip.y : batch->clip.x;
+		hi = lo + (steep ? batch->clip.h : batch->clip.w) - 1;
+		if (ustart < lo) {
+			ustart = lo;
+		}
+		if (uend > hi) {
+			uend = hi;
+		}
+		if (ustart > uend) {
+			return 0;
+		}
+	}
+
+	/*
+	* v = v1 + floor((2 * (u - u1) * dv + du) / (2 * du)), kept as quotient and remainder
+	*/
+	num = 2 * (Sint64) (ustart - u1) * dv + du;
+	v = (int) (num / (2 * du));
+	rem = (int) (num % (2 * du));
+	if (rem < 0) {
+		v--;
+		rem += 2 * du;
+	}
+	v += v1;
+	step = (dv < 0) ? -1 : 1;
+
+	run = ustart;
+	for (u = ustart; u < uend; u++) {
+		rem += 2 * dv;
+		if ((rem >= 2 * du) || (rem < 0)) {
+			rem -= step * 2 * du;
+			if (steep) {
+				_gfxBatchRect(batch, v, run, 1, u - run + 1);
+			} else {
+				_gfxBatchRect(batch, run, v, u - run + 1, 1);
+			}
+			v += step;
+			run = u + 1;
+		}
+	}
+	if (steep) {
+		return _gfxBatchRect(batch, v, run, 1, uend - run + 1);
+	}
+	return _gfxBatchRect(batch, run, v, uend - run + 1, 1);
+}
+
+/*!
+\brief Internal function filling one rectangle given by two corners, without a batch.
+
+Draws the same pixels as boxBatch, with one SDL_RenderFillRect.
+
+\param renderer The renderer to draw on.
+\param x1 X coordinate of the first corner of the rectangle.
+\param y1 Y coordinate of the first corner of the rectangle.
+\param x2 X coordinate of the second corner of the rectangle.
+\param y2 Y coordinate of the second corner of the rectangle.
+\param r The red value of the rectangle to draw.
+\param g The green value of the rectangle to draw.
+\param b The blue value of the rectangle to draw.
+\param a The alpha value of the rectangle to draw.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+static int _gfxFillRect(SDL_Renderer * renderer, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+	int result = 0;
+	SDL_Rect rect;
+
+	rect.x = (x1 < x2) ? x1 : x2;
+	rect.y = (y1 < y2) ? y1 : y2;
+	rect.w = abs(x2 - x1) + 1;
+	rect.h = abs(y2 - y1) + 1;
+	result |= SDL_SetRenderDrawBlendMode(renderer, (a == 255) ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
+	result |= SDL_SetRenderDrawColor(renderer, r, g, b, a);
+	result |= SDL_RenderFillRect(renderer, &rect);
+	return result;
+}
 
 /* ---- Pixel */
 
@@ -192,11 +968,7 @@ int hlineColor(SDL_Renderer * renderer, Sint16 x1, Sint16 x2, Sint16 y, Uint32 c
 */
 int hlineRGBA(SDL_Renderer * renderer, Sint16 x1, Sint16 x2, Sint16 y, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
 {
-	int result = 0;
-	result |= SDL_SetRenderDrawBlendMode(renderer, (a == 255) ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
-	result |= SDL_SetRenderDrawColor(renderer, r, g, b, a);
-	result |= SDL_RenderDrawLine(renderer, x1, y, x2, y);
-	return result;
+	return _gfxFillRect(renderer, x1, y, x2, y, r, g, b, a);
 }
 
 /* ---- Vline */
@@ -234,11 +1006,7 @@ int vlineColor(SDL_Renderer * renderer, Sint16 x, Sint16 y1, Sint16 y2, Uint32 c
 */
 int vlineRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y1, Sint16 y2, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
 {
-	int result = 0;
-	result |= SDL_SetRenderDrawBlendMode(renderer, (a == 255) ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
-	result |= SDL_SetRenderDrawColor(renderer, r, g, b, a);
-	result |= SDL_RenderDrawLine(renderer, x, y1, x, y2);
-	return result;
+	return _gfxFillRect(renderer, x, y1, x, y2, r, g, b, a);
 }
 
 /* ---- Rectangle */
@@ -713,59 +1481,7 @@ int boxColor(SDL_Renderer * renderer, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2
 */
 int boxRGBA(SDL_Renderer * renderer, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
 {
-	int result;
-	Sint16 tmp;
-	SDL_Rect rect;
-
-	/*
-	* Test for special cases of straight lines or single point 
-	*/
-	if (x1 == x2) {
-		if (y1 == y2) {
-			return (pixelRGBA(renderer, x1, y1, r, g, b, a));
-		} else {
-			return (vlineRGBA(renderer, x1, y1, y2, r, g, b, a));
-		}
-	} else {
-		if (y1 == y2) {
-			return (hlineRGBA(renderer, x1, x2, y1, r, g, b, a));
-		}
-	}
-
-	/*
-	* Swap x1, x2 if required 
-	*/
-	if (x1 > x2) {
-		tmp = x1;
-		x1 = x2;
-		x2 = tmp;
-	}
-
-	/*
-	* Swap y1, y2 if required 
-	*/
-	if (y1 > y2) {
-		tmp = y1;
-		y1 = y2;
-		y2 = tmp;
-	}
-
-	/* 
-	* Create destination rect
-	*/	
-	rect.x = x1;
-	rect.y = y1;
-	rect.w = x2 - x1 + 1;
-	rect.h = y2 - y1 + 1;
-	
-	/*
-	* Draw
-	*/
-	result = 0;
-	result |= SDL_SetRenderDrawBlendMode(renderer, (a == 255) ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
-	result |= SDL_SetRenderDrawColor(renderer, r, g, b, a);	
-	result |= SDL_RenderFillRect(renderer, &rect);
-	return result;
+	return _gfxFillRect(renderer, x1, y1, x2, y2, r, g, b, a);
 }
 
 /* ----- Line */
@@ -840,47 +1556,142 @@ int lineRGBA(SDL_Renderer * renderer, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2
 #define AAbits 8
 
 /*!
-\brief Internal function to draw anti-aliased line with alpha blending and endpoint control.
+\brief Internal kernel appending the weighted pixel pairs of an anti-aliased line to a batch.
+
+Step k of the line lies at major + k * majorDir on the major axis. With
+p = k * slope in 16-bit fixed point, its main pixel is p >> 16 pixels along
+the minor axis and gets weight 255 - w, the paired pixel one further gets
+weight w, where w is the fraction (p >> 8) & 255. These are the pixels and
+weights of the Wu accumulator of _aalineRGBA, computed in closed form so that
+four steps can be done at once.
+
+\param batch The batch to draw with.
+\param steep Non-zero if the major axis is Y.
+\param major Major coordinate of step 0.
+\param majorDir Direction of the major axis, 1 or -1.
+\param minor Minor coordinate of step 0.
+\param minorDir Direction of the minor axis, 1 or -1.
+\param slope Minor advance per step, in 16-bit fixed point.
+\param k1 First step to append.
+\param k2 Step past the last one to append.
+*/
+static void _gfxAALineSteps(SDL2_gfxBatch * batch, int steep, int major, int majorDir, int minor, int minorDir, Uint32 slope, int k1, int k2)
+{
+	int i, k, n;
+	Sint16 *mj, *mn;
+	Uint8 *wt;
+	Uint32 p, w;
+#ifdef GFX_SIMD_SSE2
+	__m128i vp, vmajor, vminor, vsign, vdir, vstep, vmajorStep, v255, vmask;
+	__m128i off, lo, pair, wgt;
+	int word;
+#endif
 
-This implementation of the Wu antialiasing code is based on Mike Abrash's
-DDJ article which was reprinted as Chapter 42 of his Graphics Programming
-Black Book, but has been optimized to work with SDL and utilizes 32-bit
-fixed-point arithmetic by A. Schiffler. The endpoint control allows the
-supression to draw the last pixel useful for rendering continous aa-lines
-with alpha<255.
+	while (k1 < k2) {
+		/*
+		* Main pixels go to [weights, weights + n), paired pixels to the n slots after
+		*/
+		n = (SDL2_GFX_BATCH_SIZE - batch->weights) / 2;
+		if (n == 0) {
+			gfxBatchFlush(batch);
+			continue;
+		}
+		if (n > k2 - k1) {
+			n = k2 - k1;
+		}
+		mj = (steep ? batch->weightY : batch->weightX) + batch->weights;
+		mn = (steep ? batch->weightX : batch->weightY) + batch->weights;
+		wt = batch->weight + batch->weights;
+
+		i = 0;
+#ifdef GFX_SIMD_SSE2
+		if (n >= 4) {
+			p = (Uint32) k1 * slope;
+			vp = _mm_setr_epi32((int) p, (int) (p + slope), (int) (p + 2 * slope), (int) (p + 3 * slope));
+			k = major + k1 * majorDir;
+			vmajor = _mm_setr_epi32(k, k + majorDir, k + 2 * majorDir, k + 3 * majorDir);
+			vminor = _mm_set1_epi32(minor);
+			vsign = _mm_set1_epi32(minorDir < 0 ? -1 : 0);
+			vdir = _mm_set1_epi32(minorDir);
+			vstep = _mm_set1_epi32((int) (4 * slope));
+			vmajorStep = _mm_set1_epi32(4 * majorDir);
+			v255 = _mm_set1_epi32(255);
+			vmask = _mm_set1_epi32(255);
+			for (; i + 4 <= n; i += 4) {
+				/*
+				* Minor offset, negated with the sign mask when minorDir is -1
+				*/
+				off = _mm_srli_epi32(vp, 16);
+				off = _mm_sub_epi32(_mm_xor_si128(off, vsign), vsign);
+				lo = _mm_add_epi32(vminor, off);
+				pair = _mm_add_epi32(lo, vdir);
+				wgt = _mm_and_si128(_mm_srli_epi32(vp, 8), vmask);
 
-\param renderer The renderer to draw on.
+				_mm_storel_epi64((__m128i *) (mj + i), _mm_packs_epi32(vmajor, vmajor));
+				_mm_storel_epi64((__m128i *) (mj + n + i), _mm_packs_epi32(vmajor, vmajor));
+				_mm_storel_epi64((__m128i *) (mn + i), _mm_packs_epi32(lo, lo));
+				_mm_storel_epi64((__m128i *) (mn + n + i), _mm_packs_epi32(pair, pair));
+
+				/*
+				* Bytes 0-3 are the main weights, bytes 4-7 the paired ones
+				*/
+				wgt = _mm_packs_epi32(_mm_sub_epi32(v255, wgt), wgt);
+				wgt = _mm_packus_epi16(wgt, wgt);
+				word = _mm_cvtsi128_si32(wgt);
+				memcpy(wt + i, &word, 4);
+				word = _mm_cvtsi128_si32(_mm_srli_si128(wgt, 4));
+				memcpy(wt + n + i, &word, 4);
+
+				vp = _mm_add_epi32(vp, vstep);
+				vmajor = _mm_add_epi32(vmajor, vmajorStep);
+			}
+		}
+#endif
+		for (; i < n; i++) {
+			k = k1 + i;
+			p = (Uint32) k * slope;
+			w = (p >> 8) & 255;
+			mj[i] = mj[n + i] = (Sint16) (major + k * majorDir);
+			mn[i] = (Sint16) (minor + (int) (p >> 16) * minorDir);
+			mn[n + i] = (Sint16) (mn[i] + minorDir);
+			wt[i] = (Uint8) (255 - w);
+			wt[n + i] = (Uint8) w;
+		}
+
+		batch->weights += 2 * n;
+		k1 += n;
+	}
+}
+
+/*!
+\brief Internal function appending an anti-aliased line to a batch, with endpoint control.
+
+Draws the same pixels with the same weights as the Wu line of _aalineRGBA.
+
+\param batch The batch to draw with.
 \param x1 X coordinate of the first point of the aa-line.
 \param y1 Y coordinate of the first point of the aa-line.
 \param x2 X coordinate of the second point of the aa-line.
 \param y2 Y coordinate of the second point of the aa-line.
-\param r The red value of the aa-line to draw. 
-\param g The green value of the aa-line to draw. 
-\param b The blue value of the aa-line to draw. 
-\param a The alpha value of the aa-line to draw.
 \param draw_endpoint Flag indicating if the endpoint should be drawn; draw if non-zero.
 
-\returns Returns 0 on success, -1 on failure.
+\returns Returns 0.
 */
-int _aalineRGBA(SDL_Renderer * renderer, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Uint8 r, Uint8 g, Uint8 b, Uint8 a, int draw_endpoint)
+static int _aalineBatch(SDL2_gfxBatch * batch, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, int draw_endpoint)
 {
-	Sint32 xx0, yy0, xx1, yy1;
-	int result;
-	Uint32 intshift, erracc, erradj;
-	Uint32 erracctmp, wgt;
-	int dx, dy, tmp, xdir, y0p1, x0pxdir;
+	int xx0, yy0, xx1, yy1;
+	int dx, dy, tmp, xdir;
+	int steep, major, majorDir, minor, minorDir, d;
+	int k1, k2, lo, hi;
+	Uint32 slope;
 
 	/*
-	* Keep on working with 32bit numbers 
+	* Reorder points to make dy positive 
 	*/
 	xx0 = x1;
 	yy0 = y1;
 	xx1 = x2;
 	yy1 = y2;
-
-	/*
-	* Reorder points to make dy positive 
-	*/
 	if (yy0 > yy1) {
 		tmp = yy0;
 		yy0 = yy1;
@@ -889,174 +1700,137 @@ int _aalineRGBA(SDL_Renderer * renderer, Sint16 x1, Sint16 y1, Sint16 x2, Sint16
 		xx0 = xx1;
 		xx1 = tmp;
 	}
-
-	/*
-	* Calculate distance 
-	*/
 	dx = xx1 - xx0;
 	dy = yy1 - yy0;
-
-	/*
-	* Adjust for negative dx and set xdir 
-	*/
 	if (dx >= 0) {
 		xdir = 1;
 	} else {
 		xdir = -1;
 		dx = (-dx);
 	}
-	
+
 	/*
 	* Check for special cases 
 	*/
 	if (dx == 0) {
-		/*
-		* Vertical line 
-		*/
-		if (draw_endpoint)
-		{
-			return (vlineRGBA(renderer, x1, y1, y2, r, g, b, a));
-		} else {
-			if (dy > 0) {
-				return (vlineRGBA(renderer, x1, yy0, yy0+dy, r, g, b, a));
-			} else {
-				return (pixelRGBA(renderer, x1, y1, r, g, b, a));
-			}
+		if (draw_endpoint) {
+			return vlineBatch(batch, x1, y1, y2);
+		} else if (dy > 0) {
+			return vlineBatch(batch, x1, yy0, yy0 + dy);
 		}
+		return pixelBatch(batch, x1, y1);
 	} else if (dy == 0) {
-		/*
-		* Horizontal line 
-		*/
-		if (draw_endpoint)
-		{
-			return (hlineRGBA(renderer, x1, x2, y1, r, g, b, a));
-		} else {
-			if (dx > 0) {
-				return (hlineRGBA(renderer, xx0, xx0+dx, y1, r, g, b, a));
-			} else {
-				return (pixelRGBA(renderer, x1, y1, r, g, b, a));
-			}
+		if (draw_endpoint) {
+			return hlineBatch(batch, x1, x2, y1);
+		} else if (dx > 0) {
+			return hlineBatch(batch, xx0, xx0 + dx, y1);
 		}
+		return pixelBatch(batch, x1, y1);
 	} else if ((dx == dy) && (draw_endpoint)) {
-		/*
-		* Diagonal line (with endpoint)
-		*/
-		return (lineRGBA(renderer, x1, y1, x2, y2,  r, g, b, a));
+		return lineBatch(batch, x1, y1, x2, y2);
 	}
 
-
-	/*
-	* Line is not horizontal, vertical or diagonal (with endpoint)
-	*/
-	result = 0;
-
-	/*
-	* Zero accumulator 
-	*/
-	erracc = 0;
-
-	/*
-	* # of bits by which to shift erracc to get intensity level 
-	*/
-	intshift = 32 - AAbits;
-
 	/*
-	* Draw the initial pixel in the foreground color 
+	* Initial pixel in the full color, then the weighted pairs of steps 1 to d - 1
 	*/
-	result |= pixelRGBA(renderer, x1, y1, r, g, b, a);
-
-	/*
-	* x-major or y-major? 
-	*/
-	if (dy > dx) {
+	pixelBatch(batch, x1, y1);
+
+	steep = dy > dx;
+	if (steep) {
+		major = yy0;
+		majorDir = 1;
+		minor = xx0;
+		minorDir = xdir;
+		d = dy;
+		slope = ((Uint32) dx << 16) / (Uint32) dy;
+	} else {
+		major = xx0;
+		majorDir = xdir;
+		minor = yy0;
+		minorDir = 1;
+		d = dx;
+		slope = ((Uint32) dy << 16) / (Uint32) dx;
+	}
 
+	k1 = 1;
+	k2 = d;
+	if (batch->pixels != NULL) {
 		/*
-		* y-major.  Calculate 16-bit fixed point fractional part of a pixel that
-		* X advances every time Y advances 1 pixel, truncating the result so that
-		* we won't overrun the endpoint along the X axis 
-		*/
-		/*
-		* Not-so-portable version: erradj = ((Uint64)dx << 32) / (Uint64)dy; 
+		* Only the steps whose major coordinate is inside the clip rectangle
 		*/
-		erradj = ((dx << 16) / dy) << 16;
+		lo = steep ? batch->clip.y : batch->clip.x;
+		hi = lo + (steep ? batch->clip.h : batch->clip.w) - 1;
+		if (majorDir > 0) {
+			lo -= major;
+			hi -= major;
+		} else {
+			tmp = major - hi;
+			hi = major - lo;
+			lo = tmp;
+		}
+		if (k1 < lo) {
+			k1 = lo;
+		}
+		if (k2 > hi + 1) {
+			k2 = hi + 1;
+		}
+	}
+	_gfxAALineSteps(batch, steep, major, majorDir, minor, minorDir, slope, k1, k2);
 
+	if (draw_endpoint) {
 		/*
-		* draw all pixels other than the first and last 
+		* Final pixel, always exactly intersected by the line 
 		*/
-		x0pxdir = xx0 + xdir;
-		while (--dy) {
-			erracctmp = erracc;
-			erracc += erradj;
-			if (erracc <= erracctmp) {
-				/*
-				* rollover in error accumulator, x coord advances 
-				*/
-				xx0 = x0pxdir;
-				x0pxdir += xdir;
-			}
-			yy0++;		/* y-major so always advance Y */
+		pixelBatch(batch, x2, y2);
+	}
+	return 0;
+}
 
-			/*
-			* the AAbits most significant bits of erracc give us the intensity
-			* weighting for this pixel, and the complement of the weighting for
-			* the paired pixel. 
-			*/
-			wgt = (erracc >> intshift) & 255;
-			result |= pixelRGBAWeight (renderer, xx0, yy0, r, g, b, a, 255 - wgt);
-			result |= pixelRGBAWeight (renderer, x0pxdir, yy0, r, g, b, a, wgt);
-		}
+/*!
+\brief Append an anti-aliased line to a batch.
 
-	} else {
+\param batch The batch to draw with.
+\param x1 X coordinate of the first point of the aa-line.
+\param y1 Y coordinate of the first point of the aa-line.
+\param x2 X coordinate of the second point of the aa-line.
+\param y2 Y coordinate of the second point of the aa-line.
 
-		/*
-		* x-major line.  Calculate 16-bit fixed-point fractional part of a pixel
-		* that Y advances each time X advances 1 pixel, truncating the result so
-		* that we won't overrun the endpoint along the X axis. 
-		*/
-		/*
-		* Not-so-portable version: erradj = ((Uint64)dy << 32) / (Uint64)dx; 
-		*/
-		erradj = ((dy << 16) / dx) << 16;
+\returns Returns 0.
+*/
+int aalineBatch(SDL2_gfxBatch * batch, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2)
+{
+	return _aalineBatch(batch, x1, y1, x2, y2, 1);
+}
 
-		/*
-		* draw all pixels other than the first and last 
-		*/
-		y0p1 = yy0 + 1;
-		while (--dx) {
+/*!
+\brief Internal function to draw anti-aliased line with alpha blending and endpoint control.
 
-			erracctmp = erracc;
-			erracc += erradj;
-			if (erracc <= erracctmp) {
-				/*
-				* Accumulator turned over, advance y 
-				*/
-				yy0 = y0p1;
-				y0p1++;
-			}
-			xx0 += xdir;	/* x-major so always advance X */
-			/*
-			* the AAbits most significant bits of erracc give us the intensity
-			* weighting for this pixel, and the complement of the weighting for
-			* the paired pixel. 
-			*/
-			wgt = (erracc >> intshift) & 255;
-			result |= pixelRGBAWeight (renderer, xx0, yy0, r, g, b, a, 255 - wgt);
-			result |= pixelRGBAWeight (renderer, xx0, y0p1, r, g, b, a, wgt);
-		}
-	}
+This implementation of the Wu antialiasing code is based on Mike Abrash's
+DDJ article which was reprinted as Chapter 42 of his Graphics Programming
+Black Book, but has been optimized to work with SDL and utilizes 32-bit
+fixed-point arithmetic by A. Schiffler. The endpoint control allows the
+supression to draw the last pixel useful for rendering continous aa-lines
+with alpha<255. The weighted pixels are batched, see _aalineBatch.
 
-	/*
-	* Do we have to draw the endpoint 
-	*/
-	if (draw_endpoint) {
-		/*
-		* Draw final pixel, always exactly intersected by the line and doesn't
-		* need to be weighted. 
-		*/
-		result |= pixelRGBA (renderer, x2, y2, r, g, b, a);
-	}
+\param renderer The renderer to draw on.
+\param x1 X coordinate of the first point of the aa-line.
+\param y1 Y coordinate of the first point of the aa-line.
+\param x2 X coordinate of the second point of the aa-line.
+\param y2 Y coordinate of the second point of the aa-line.
+\param r The red value of the aa-line to draw. 
+\param g The green value of the aa-line to draw. 
+\param b The blue value of the aa-line to draw. 
+\param a The alpha value of the aa-line to draw.
+\param draw_endpoint Flag indicating if the endpoint should be drawn; draw if non-zero.
 
-	return (result);
+\returns Returns 0 on success, -1 on failure.
+*/
+int _aalineRGBA(SDL_Renderer * renderer, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Uint8 r, Uint8 g, Uint8 b, Uint8 a, int draw_endpoint)
+{
+	SDL2_gfxBatch *batch = &gfxPrimitivesBatchThread;
+	gfxBatchBegin(batch, renderer, r, g, b, a);
+	_aalineBatch(batch, x1, y1, x2, y2, draw_endpoint);
+	return gfxBatchEnd(batch);
 }
 
 /*!
@@ -1442,22 +2216,17 @@ int filledCircleColor(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rad, U
 }
 
 /*!
-\brief Draw filled circle with blending.
+\brief Append a filled circle to a batch.
 
-\param renderer The renderer to draw on.
+\param batch The batch to draw with.
 \param x X coordinate of the center of the filled circle.
 \param y Y coordinate of the center of the filled circle.
 \param rad Radius in pixels of the filled circle.
-\param r The red value of the filled circle to draw. 
-\param g The green value of the filled circle to draw. 
-\param b The blue value of the filled circle to draw. 
-\param a The alpha value of the filled circle to draw.
 
 \returns Returns 0 on success, -1 on failure.
 */
-int filledCircleRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rad, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+int filledCircleBatch(SDL2_gfxBatch * batch, Sint16 x, Sint16 y, Sint16 rad)
 {
-	int result;
 	Sint16 cx = 0;
 	Sint16 cy = rad;
 	Sint16 ocx = (Sint16) 0xffff;
@@ -1479,16 +2248,9 @@ int filledCircleRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rad, Ui
 	* Special case for rad=0 - draw a point 
 	*/
 	if (rad == 0) {
-		return (pixelRGBA(renderer, x, y, r, g, b, a));
+		return (pixelBatch(batch, x, y));
 	}
 
-	/*
-	* Set color
-	*/
-	result = 0;
-	result |= SDL_SetRenderDrawBlendMode(renderer, (a == 255) ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
-	result |= SDL_SetRenderDrawColor(renderer, r, g, b, a);
-
 	/*
 	* Draw 
 	*/
@@ -1501,10 +2263,10 @@ int filledCircleRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rad, Ui
 			if (cy > 0) {
 				ypcy = y + cy;
 				ymcy = y - cy;
-				result |= hline(renderer, xmcx, xpcx, ypcy);
-				result |= hline(renderer, xmcx, xpcx, ymcy);
+				hlineBatch(batch, xmcx, xpcx, ypcy);
+				hlineBatch(batch, xmcx, xpcx, ymcy);
 			} else {
-				result |= hline(renderer, xmcx, xpcx, y);
+				hlineBatch(batch, xmcx, xpcx, y);
 			}
 			ocy = cy;
 		}
@@ -1513,10 +2275,10 @@ int filledCircleRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rad, Ui
 				if (cx > 0) {
 					ypcx = y + cx;
 					ymcx = y - cx;
-					result |= hline(renderer, xmcy, xpcy, ymcx);
-					result |= hline(renderer, xmcy, xpcy, ypcx);
+					hlineBatch(batch, xmcy, xpcy, ymcx);
+					hlineBatch(batch, xmcy, xpcy, ypcx);
 				} else {
-					result |= hline(renderer, xmcy, xpcy, y);
+					hlineBatch(batch, xmcy, xpcy, y);
 				}
 			}
 			ocx = cx;
@@ -1538,6 +2300,31 @@ int filledCircleRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rad, Ui
 		cx++;
 	} while (cx <= cy);
 
+	return (0);
+}
+
+/*!
+\brief Draw filled circle with blending.
+
+\param renderer The renderer to draw on.
+\param x X coordinate of the center of the filled circle.
+\param y Y coordinate of the center of the filled circle.
+\param rad Radius in pixels of the filled circle.
+\param r The red value of the filled circle to draw. 
+\param g The green value of the filled circle to draw. 
+\param b The blue value of the filled circle to draw. 
+\param a The alpha value of the filled circle to draw.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int filledCircleRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rad, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+	SDL2_gfxBatch *batch = &gfxPrimitivesBatchThread;
+	int result;
+
+	gfxBatchBegin(batch, renderer, r, g, b, a);
+	result = filledCircleBatch(batch, x, y, rad);
+	result |= gfxBatchEnd(batch);
 	return (result);
 }
 
@@ -1992,23 +2779,18 @@ int filledEllipseColor(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rx, S
 }
 
 /*!
-\brief Draw filled ellipse with blending.
+\brief Append a filled ellipse to a batch.
 
-\param renderer The renderer to draw on.
+\param batch The batch to draw with.
 \param x X coordinate of the center of the filled ellipse.
 \param y Y coordinate of the center of the filled ellipse.
 \param rx Horizontal radius in pixels of the filled ellipse.
 \param ry Vertical radius in pixels of the filled ellipse.
-\param r The red value of the filled ellipse to draw. 
-\param g The green value of the filled ellipse to draw. 
-\param b The blue value of the filled ellipse to draw. 
-\param a The alpha value of the filled ellipse to draw.
 
 \returns Returns 0 on success, -1 on failure.
 */
-int filledEllipseRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rx, Sint16 ry, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+int filledEllipseBatch(SDL2_gfxBatch * batch, Sint16 x, Sint16 y, Sint16 rx, Sint16 ry)
 {
-	int result;
 	int ix, iy;
 	int h, i, j, k;
 	int oh, oi, oj, ok;
@@ -2028,22 +2810,15 @@ int filledEllipseRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rx, Si
 	* Special case for rx=0 - draw a vline 
 	*/
 	if (rx == 0) {
-		return (vlineRGBA(renderer, x, y - ry, y + ry, r, g, b, a));
+		return (vlineBatch(batch, x, y - ry, y + ry));
 	}
 	/*
 	* Special case for ry=0 - draw a hline 
 	*/
 	if (ry == 0) {
-		return (hlineRGBA(renderer, x - rx, x + rx, y, r, g, b, a));
+		return (hlineBatch(batch, x - rx, x + rx, y));
 	}
 
-	/*
-	* Set color
-	*/
-	result = 0;
-	result |= SDL_SetRenderDrawBlendMode(renderer, (a == 255) ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
-	result |= SDL_SetRenderDrawColor(renderer, r, g, b, a);
-
 	/*
 	* Init vars 
 	*/
@@ -2066,10 +2841,10 @@ int filledEllipseRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rx, Si
 				xph = x + h;
 				xmh = x - h;
 				if (k > 0) {
-					result |= hline(renderer, xmh, xph, y + k);
-					result |= hline(renderer, xmh, xph, y - k);
+					hlineBatch(batch, xmh, xph, y + k);
+					hlineBatch(batch, xmh, xph, y - k);
 				} else {
-					result |= hline(renderer, xmh, xph, y);
+					hlineBatch(batch, xmh, xph, y);
 				}
 				ok = k;
 			}
@@ -2077,10 +2852,10 @@ int filledEllipseRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rx, Si
 				xmi = x - i;
 				xpi = x + i;
 				if (j > 0) {
-					result |= hline(renderer, xmi, xpi, y + j);
-					result |= hline(renderer, xmi, xpi, y - j);
+					hlineBatch(batch, xmi, xpi, y + j);
+					hlineBatch(batch, xmi, xpi, y - j);
 				} else {
-					result |= hline(renderer, xmi, xpi, y);
+					hlineBatch(batch, xmi, xpi, y);
 				}
 				oj = j;
 			}
@@ -2103,10 +2878,10 @@ int filledEllipseRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rx, Si
 				xmj = x - j;
 				xpj = x + j;
 				if (i > 0) {
-					result |= hline(renderer, xmj, xpj, y + i);
-					result |= hline(renderer, xmj, xpj, y - i);
+					hlineBatch(batch, xmj, xpj, y + i);
+					hlineBatch(batch, xmj, xpj, y - i);
 				} else {
-					result |= hline(renderer, xmj, xpj, y);
+					hlineBatch(batch, xmj, xpj, y);
 				}
 				oi = i;
 			}
@@ -2114,10 +2889,10 @@ int filledEllipseRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rx, Si
 				xmk = x - k;
 				xpk = x + k;
 				if (h > 0) {
-					result |= hline(renderer, xmk, xpk, y + h);
-					result |= hline(renderer, xmk, xpk, y - h);
+					hlineBatch(batch, xmk, xpk, y + h);
+					hlineBatch(batch, xmk, xpk, y - h);
 				} else {
-					result |= hline(renderer, xmk, xpk, y);
+					hlineBatch(batch, xmk, xpk, y);
 				}
 				oh = h;
 			}
@@ -2128,6 +2903,32 @@ int filledEllipseRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rx, Si
 		} while (i > h);
 	}
 
+	return (0);
+}
+
+/*!
+\brief Draw filled ellipse with blending.
+
+\param renderer The renderer to draw on.
+\param x X coordinate of the center of the filled ellipse.
+\param y Y coordinate of the center of the filled ellipse.
+\param rx Horizontal radius in pixels of the filled ellipse.
+\param ry Vertical radius in pixels of the filled ellipse.
+\param r The red value of the filled ellipse to draw. 
+\param g The green value of the filled ellipse to draw. 
+\param b The blue value of the filled ellipse to draw. 
+\param a The alpha value of the filled ellipse to draw.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int filledEllipseRGBA(SDL_Renderer * renderer, Sint16 x, Sint16 y, Sint16 rx, Sint16 ry, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+	SDL2_gfxBatch *batch = &gfxPrimitivesBatchThread;
+	int result;
+
+	gfxBatchBegin(batch, renderer, r, g, b, a);
+	result = filledEllipseBatch(batch, x, y, rx, ry);
+	result |= gfxBatchEnd(batch);
 	return (result);
 }
 
@@ -2472,6 +3273,34 @@ int aatrigonRGBA(SDL_Renderer * renderer,  Sint16 x1, Sint16 y1, Sint16 x2, Sint
 
 /* ------ Filled Trigon */
 
+/*!
+\brief Append a filled trigon (triangle) to a batch.
+
+\param batch The batch to draw with.
+\param x1 X coordinate of the first point of the filled trigon.
+\param y1 Y coordinate of the first point of the filled trigon.
+\param x2 X coordinate of the second point of the filled trigon.
+\param y2 Y coordinate of the second point of the filled trigon.
+\param x3 X coordinate of the third point of the filled trigon.
+\param y3 Y coordinate of the third point of the filled trigon.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int filledTrigonBatch(SDL2_gfxBatch * batch, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Sint16 x3, Sint16 y3)
+{
+	Sint16 vx[3]; 
+	Sint16 vy[3];
+
+	vx[0]=x1;
+	vx[1]=x2;
+	vx[2]=x3;
+	vy[0]=y1;
+	vy[1]=y2;
+	vy[2]=y3;
+
+	return(filledPolygonBatch(batch,vx,vy,3));
+}
+
 /*!
 \brief Draw filled trigon (triangle) with alpha blending.
 
@@ -2701,24 +3530,18 @@ int aapolygonColor(SDL_Renderer * renderer, const Sint16 * vx, const Sint16 * vy
 }
 
 /*!
-\brief Draw anti-aliased polygon with alpha blending.
+\brief Append an anti-aliased polygon to a batch.
 
-\param renderer The renderer to draw on.
+\param batch The batch to draw with.
 \param vx Vertex array containing X coordinates of the points of the aa-polygon.
 \param vy Vertex array containing Y coordinates of the points of the aa-polygon.
 \param n Number of points in the vertex array. Minimum number is 3.
-\param r The red value of the aa-polygon to draw. 
-\param g The green value of the aa-polygon to draw. 
-\param b The blue value of the aa-polygon to draw. 
-\param a The alpha value of the aa-polygon to draw.
 
 \returns Returns 0 on success, -1 on failure.
 */
-int aapolygonRGBA(SDL_Renderer * renderer, const Sint16 * vx, const Sint16 * vy, int n, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+int aapolygonBatch(SDL2_gfxBatch * batch, const Sint16 * vx, const Sint16 * vy, int n)
 {
-	int result;
 	int i;
-	const Sint16 *x1, *y1, *x2, *y2;
 
 	/*
 	* Vertex array NULL check 
@@ -2738,27 +3561,38 @@ int aapolygonRGBA(SDL_Renderer * renderer, const Sint16 * vx, const Sint16 * vy,
 	}
 
 	/*
-	* Pointer setup 
-	*/
-	x1 = x2 = vx;
-	y1 = y2 = vy;
-	x2++;
-	y2++;
-
-	/*
-	* Draw 
+	* Edges without their endpoint, so that shared vertices are drawn once 
 	*/
-	result = 0;
 	for (i = 1; i < n; i++) {
-		result |= _aalineRGBA(renderer, *x1, *y1, *x2, *y2, r, g, b, a, 0);
-		x1 = x2;
-		y1 = y2;
-		x2++;
-		y2++;
+		_aalineBatch(batch, vx[i - 1], vy[i - 1], vx[i], vy[i], 0);
 	}
+	_aalineBatch(batch, vx[n - 1], vy[n - 1], vx[0], vy[0], 0);
+
+	return 0;
+}
+
+/*!
+\brief Draw anti-aliased polygon with alpha blending.
+
+\param renderer The renderer to draw on.
+\param vx Vertex array containing X coordinates of the points of the aa-polygon.
+\param vy Vertex array containing Y coordinates of the points of the aa-polygon.
+\param n Number of points in the vertex array. Minimum number is 3.
+\param r The red value of the aa-polygon to draw. 
+\param g The green value of the aa-polygon to draw. 
+\param b The blue value of the aa-polygon to draw. 
+\param a The alpha value of the aa-polygon to draw.
 
-	result |= _aalineRGBA(renderer, *x1, *y1, *vx, *vy, r, g, b, a, 0);
+\returns Returns 0 on success, -1 on failure.
+*/
+int aapolygonRGBA(SDL_Renderer * renderer, const Sint16 * vx, const Sint16 * vy, int n, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+	SDL2_gfxBatch *batch = &gfxPrimitivesBatchThread;
+	int result;
 
+	gfxBatchBegin(batch, renderer, r, g, b, a);
+	result = aapolygonBatch(batch, vx, vy, n);
+	result |= gfxBatchEnd(batch);
 	return (result);
 }
 
@@ -2778,50 +3612,110 @@ int _gfxPrimitivesCompareInt(const void *a, const void *b)
 }
 
 /*!
-\brief Global vertex array to use if optional parameters are not given in filledPolygonMT calls.
+\brief Per-thread scratch array to use if optional parameters are not given in polygon MT calls.
+
+Note: Each thread grows its own array, so the default calls are safe to run concurrently.
+*/
+static GFX_THREAD_LOCAL int *gfxPrimitivesPolyIntsThread = NULL;
 
-Note: Used for non-multithreaded (default) operation of filledPolygonMT.
+/*!
+\brief Size in ints of the per-thread scratch array.
 */
-static int *gfxPrimitivesPolyIntsGlobal = NULL;
+static GFX_THREAD_LOCAL int gfxPrimitivesPolyAllocatedThread = 0;
 
 /*!
-\brief Flag indicating if global vertex array was already allocated.
+\brief Release the scratch arrays of the calling thread.
 
-Note: Used for non-multithreaded (default) operation of filledPolygonMT.
+Worker threads drawing polygons without their own scratch arrays should call
+this before they exit; the array is allocated again when next needed.
 */
-static int gfxPrimitivesPolyAllocatedGlobal = 0;
+void gfxPrimitivesPolyFree(void)
+{
+	free(gfxPrimitivesPolyIntsThread);
+	gfxPrimitivesPolyIntsThread = NULL;
+	gfxPrimitivesPolyAllocatedThread = 0;
+}
 
 /*!
-\brief Draw filled polygon with alpha blending (multi-threaded capable).
+\brief Internal edge record of the filled polygon edge table.
 
-Note: The last two parameters are optional; but are required for multithreaded operation.  
+The X intersection of the edge with scanline y is kept exactly as
+((65536 * (y - y1)) / (y2 - y1)) * (x2 - x1) + 65536 * x1, but the
+quotient is stepped incrementally from one scanline to the next.
+*/
+typedef struct {
+	int y1, y2;
+	int dx, x1;
+	int q, rem;
+	int qstep, rstep, dy;
+} _gfxPolyEdge;
 
-\param renderer The renderer to draw on.
+#define GFX_POLY_EDGE_INTS ((int)(sizeof(_gfxPolyEdge) / sizeof(int)))
+
+/*!
+\brief Internal helper growing a polygon scratch array.
+
+\param buffer Pointer to the scratch array, reallocated on growth.
+\param allocated Pointer to the allocated size of the array, in ints.
+\param count Requested size, in ints.
+
+\returns Returns 0 on success, -1 on failure (the array is then released).
+*/
+static int _gfxPrimitivesPolyReserve(int **buffer, int *allocated, int count)
+{
+	int *grown;
+
+	if (*buffer != NULL && *allocated >= count) {
+		return 0;
+	}
+	if (*buffer != NULL && count < 2 * *allocated) {
+		count = 2 * *allocated;
+	}
+	grown = (int *) realloc(*buffer, sizeof(int) * count);
+	if (grown == NULL) {
+		free(*buffer);
+		*buffer = NULL;
+		*allocated = 0;
+		return -1;
+	}
+	*buffer = grown;
+	*allocated = count;
+	return 0;
+}
+
+/*!
+\brief Append a filled polygon to a batch (multi-threaded capable).
+
+Scanline fill driven by an edge table: edges enter the active list at their
+top scanline and leave it at their bottom one, X intersections are stepped
+incrementally and every span goes to the batch.
+
+Note: The last two parameters are optional; without them each thread uses its own scratch array.  
+
+\param batch The batch to draw with.
 \param vx Vertex array containing X coordinates of the points of the filled polygon.
 \param vy Vertex array containing Y coordinates of the points of the filled polygon.
 \param n Number of points in the vertex array. Minimum number is 3.
-\param r The red value of the filled polygon to draw. 
-\param g The green value of the filled polygon to draw. 
-\param b The blue value of the filled polygon to draw. 
-\param a The alpha value of the filled polygon to draw.
-\param polyInts Preallocated, temporary vertex array used for sorting vertices. Required for multithreaded operation; set to NULL otherwise.
-\param polyAllocated Flag indicating if temporary vertex array was allocated. Required for multithreaded operation; set to NULL otherwise.
+\param polyInts Preallocated, temporary scratch array used for edges and intersections. Set to NULL to use the per-thread array.
+\param polyAllocated Size in ints of the temporary scratch array. Set to NULL to use the per-thread array.
 
 \returns Returns 0 on success, -1 on failure.
 */
-int filledPolygonRGBAMT(SDL_Renderer * renderer, const Sint16 * vx, const Sint16 * vy, int n, Uint8 r, Uint8 g, Uint8 b, Uint8 a, int **polyInts, int *polyAllocated)
+int filledPolygonBatchMT(SDL2_gfxBatch * batch, const Sint16 * vx, const Sint16 * vy, int n, int **polyInts, int *polyAllocated)
 {
 	int result;
-	int i;
+	int i, j, k;
 	int y, xa, xb;
 	int miny, maxy;
 	int x1, y1;
 	int x2, y2;
-	int ind1, ind2;
-	int ints;
-	int *gfxPrimitivesPolyInts = NULL;
-	int *gfxPrimitivesPolyIntsNew = NULL;
-	int gfxPrimitivesPolyAllocated = 0;
+	int edges, next, active, ints;
+	int *scratch;
+	int allocated;
+	_gfxPolyEdge *edge, e;
+	int *xs;
+	int ystart, yend;
+	Sint64 d;
 
 	/*
 	* Vertex array NULL check 
@@ -2844,125 +3738,193 @@ int filledPolygonRGBAMT(SDL_Renderer * renderer, const Sint16 * vx, const Sint16
 	* Map polygon cache  
 	*/
 	if ((polyInts==NULL) || (polyAllocated==NULL)) {
-		/* Use global cache */
-		gfxPrimitivesPolyInts = gfxPrimitivesPolyIntsGlobal;
-		gfxPrimitivesPolyAllocated = gfxPrimitivesPolyAllocatedGlobal;
-	} else {
-		/* Use local cache */
-		gfxPrimitivesPolyInts = *polyInts;
-		gfxPrimitivesPolyAllocated = *polyAllocated;
-	}
-
-	/*
-	* Allocate temp array, only grow array 
-	*/
-	if (!gfxPrimitivesPolyAllocated) {
-		gfxPrimitivesPolyInts = (int *) malloc(sizeof(int) * n);
-		gfxPrimitivesPolyAllocated = n;
-	} else {
-		if (gfxPrimitivesPolyAllocated < n) {
-			gfxPrimitivesPolyIntsNew = (int *) realloc(gfxPrimitivesPolyInts, sizeof(int) * n);
-			if (!gfxPrimitivesPolyIntsNew) {
-				if (!gfxPrimitivesPolyInts) {
-					free(gfxPrimitivesPolyInts);
-					gfxPrimitivesPolyInts = NULL;
-				}
-				gfxPrimitivesPolyAllocated = 0;
-			} else {
-				gfxPrimitivesPolyInts = gfxPrimitivesPolyIntsNew;
-				gfxPrimitivesPolyAllocated = n;
-			}
-		}
-	}
-
-	/*
-	* Check temp array
-	*/
-	if (gfxPrimitivesPolyInts==NULL) {        
-		gfxPrimitivesPolyAllocated = 0;
-	}
-
-	/*
-	* Update cache variables
-	*/
-	if ((polyInts==NULL) || (polyAllocated==NULL)) { 
-		gfxPrimitivesPolyIntsGlobal =  gfxPrimitivesPolyInts;
-		gfxPrimitivesPolyAllocatedGlobal = gfxPrimitivesPolyAllocated;
-	} else {
-		*polyInts = gfxPrimitivesPolyInts;
-		*polyAllocated = gfxPrimitivesPolyAllocated;
+		/* Use per-thread cache */
+		polyInts = &gfxPrimitivesPolyIntsThread;
+		polyAllocated = &gfxPrimitivesPolyAllocatedThread;
 	}
+	scratch = *polyInts;
+	allocated = *polyAllocated;
 
 	/*
-	* Check temp array again
+	* Scratch layout: n edges, then n intersections
 	*/
-	if (gfxPrimitivesPolyInts==NULL) {        
-		return(-1);
-	}
+	result = _gfxPrimitivesPolyReserve(&scratch, &allocated, n * (GFX_POLY_EDGE_INTS + 1));
 
 	/*
-	* Determine Y maxima 
+	* Build the edge table, sorted by top scanline; horizontal edges are skipped
 	*/
+	edges = 0;
 	miny = vy[0];
 	maxy = vy[0];
-	for (i = 1; (i < n); i++) {
+	for (i = 0; (result == 0) && (i < n); i++) {
 		if (vy[i] < miny) {
 			miny = vy[i];
 		} else if (vy[i] > maxy) {
 			maxy = vy[i];
 		}
+
+		j = (i == 0) ? n - 1 : i - 1;
+		if (vy[j] < vy[i]) {
+			x1 = vx[j]; y1 = vy[j];
+			x2 = vx[i]; y2 = vy[i];
+		} else if (vy[j] > vy[i]) {
+			x1 = vx[i]; y1 = vy[i];
+			x2 = vx[j]; y2 = vy[j];
+		} else {
+			continue;
+		}
+
+		e.y1 = y1;
+		e.y2 = y2;
+		e.dx = x2 - x1;
+		e.x1 = 65536 * x1;
+		e.dy = y2 - y1;
+		e.q = 0;
+		e.rem = 0;
+		e.qstep = 65536 / e.dy;
+		e.rstep = 65536 % e.dy;
+
+		edge = (_gfxPolyEdge *) scratch;
+		for (k = edges; (k > 0) && (edge[k - 1].y1 > e.y1); k--) {
+			edge[k] = edge[k - 1];
+		}
+		edge[k] = e;
+		edges++;
 	}
 
 	/*
-	* Draw, scanning y 
+	* Scan y, keeping the active edges at the front of the table
 	*/
-	result = 0;
-	for (y = miny; (y <= maxy); y++) {
+	next = 0;
+	active = 0;
+	edge = (_gfxPolyEdge *) scratch;
+	xs = scratch + n * GFX_POLY_EDGE_INTS;
+
+	/*
+	* Software targets only scan the rows of their clip rectangle: edges crossing
+	* its top start active, with their quotient set as if stepped from their top
+	*/
+	ystart = miny;
+	yend = maxy;
+	if (batch->pixels != NULL) {
+		if (ystart < batch->clip.y) {
+			ystart = batch->clip.y;
+		}
+		if (yend > batch->clip.y + batch->clip.h - 1) {
+			yend = batch->clip.y + batch->clip.h - 1;
+		}
+		while ((next < edges) && (edge[next].y1 < ystart)) {
+			d = (Sint64) 65536 * (ystart - edge[next].y1);
+			edge[next].q = (int) (d / edge[next].dy);
+			edge[next].rem = (int) (d % edge[next].dy);
+			active++;
+			next++;
+		}
+	}
+
+	for (y = ystart; (result == 0) && (y <= yend); y++) {
+
+		/* Edges starting on this scanline become active */
+		while ((next < edges) && (edge[next].y1 == y)) {
+			e = edge[next];
+			edge[next] = edge[active];
+			edge[active] = e;
+			active++;
+			next++;
+		}
+
+		/* Intersections of the active edges, those ending here leave the list
+		   (except on the last scanline, which closes the bottom of the polygon) */
 		ints = 0;
-		for (i = 0; (i < n); i++) {
-			if (!i) {
-				ind1 = n - 1;
-				ind2 = 0;
-			} else {
-				ind1 = i - 1;
-				ind2 = i;
+		for (i = 0; (i < active); ) {
+			if ((y >= edge[i].y2) && (y < maxy)) {
+				active--;
+				e = edge[i];
+				edge[i] = edge[active];
+				edge[active] = e;
+				continue;
 			}
-			y1 = vy[ind1];
-			y2 = vy[ind2];
-			if (y1 < y2) {
-				x1 = vx[ind1];
-				x2 = vx[ind2];
-			} else if (y1 > y2) {
-				y2 = vy[ind1];
-				y1 = vy[ind2];
-				x2 = vx[ind1];
-				x1 = vx[ind2];
-			} else {
+			if ((y == maxy) && (edge[i].y2 != maxy)) {
+				i++;
 				continue;
 			}
-			if ( ((y >= y1) && (y < y2)) || ((y == maxy) && (y > y1) && (y <= y2)) ) {
-				gfxPrimitivesPolyInts[ints++] = ((65536 * (y - y1)) / (y2 - y1)) * (x2 - x1) + (65536 * x1);
-			} 	    
+			xa = edge[i].q * edge[i].dx + edge[i].x1;
+			for (k = ints; (k > 0) && (xs[k - 1] > xa); k--) {
+				xs[k] = xs[k - 1];
+			}
+			xs[k] = xa;
+			ints++;
+
+			/* Quotient for the next scanline */
+			edge[i].q += edge[i].qstep;
+			edge[i].rem += edge[i].rstep;
+			if (edge[i].rem >= edge[i].dy) {
+				edge[i].rem -= edge[i].dy;
+				edge[i].q++;
+			}
+			i++;
 		}
 
-		qsort(gfxPrimitivesPolyInts, ints, sizeof(int), _gfxPrimitivesCompareInt);
-
-		/*
-		* Set color 
-		*/
-		result = 0;
-	    result |= SDL_SetRenderDrawBlendMode(renderer, (a == 255) ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
-		result |= SDL_SetRenderDrawColor(renderer, r, g, b, a);	
-
-		for (i = 0; (i < ints); i += 2) {
-			xa = gfxPrimitivesPolyInts[i] + 1;
+		/* Spans of this scanline */
+		for (i = 0; (i + 1 < ints); i += 2) {
+			xa = xs[i] + 1;
 			xa = (xa >> 16) + ((xa & 32768) >> 15);
-			xb = gfxPrimitivesPolyInts[i+1] - 1;
+			xb = xs[i+1] - 1;
 			xb = (xb >> 16) + ((xb & 32768) >> 15);
-			result |= hline(renderer, xa, xb, y);
+			_gfxBatchRect(batch, (xa < xb) ? xa : xb, y, ((xa < xb) ? xb - xa : xa - xb) + 1, 1);
 		}
 	}
 
+	/*
+	* Update cache variables
+	*/
+	*polyInts = scratch;
+	*polyAllocated = allocated;
+
+	return (result);
+}
+
+/*!
+\brief Append a filled polygon to a batch.
+
+\param batch The batch to draw with.
+\param vx Vertex array containing X coordinates of the points of the filled polygon.
+\param vy Vertex array containing Y coordinates of the points of the filled polygon.
+\param n Number of points in the vertex array. Minimum number is 3.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int filledPolygonBatch(SDL2_gfxBatch * batch, const Sint16 * vx, const Sint16 * vy, int n)
+{
+	return filledPolygonBatchMT(batch, vx, vy, n, NULL, NULL);
+}
+
+/*!
+\brief Draw filled polygon with alpha blending (multi-threaded capable).
+
+Note: The last two parameters are optional; without them each thread uses its own scratch array.  
+
+\param renderer The renderer to draw on.
+\param vx Vertex array containing X coordinates of the points of the filled polygon.
+\param vy Vertex array containing Y coordinates of the points of the filled polygon.
+\param n Number of points in the vertex array. Minimum number is 3.
+\param r The red value of the filled polygon to draw. 
+\param g The green value of the filled polygon to draw. 
+\param b The blue value of the filled polygon to draw. 
+\param a The alpha value of the filled polygon to draw.
+\param polyInts Preallocated, temporary scratch array used for edges and intersections. Set to NULL to use the per-thread array.
+\param polyAllocated Size in ints of the temporary scratch array. Set to NULL to use the per-thread array.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int filledPolygonRGBAMT(SDL_Renderer * renderer, const Sint16 * vx, const Sint16 * vy, int n, Uint8 r, Uint8 g, Uint8 b, Uint8 a, int **polyInts, int *polyAllocated)
+{
+	SDL2_gfxBatch *batch = &gfxPrimitivesBatchThread;
+	int result;
+
+	gfxBatchBegin(batch, renderer, r, g, b, a);
+	result = filledPolygonBatchMT(batch, vx, vy, n, polyInts, polyAllocated);
+	result |= gfxBatchEnd(batch);
 	return (result);
 }
 
@@ -3113,8 +4075,8 @@ int _HLineTextured(SDL_Renderer *renderer, Sint16 x1, Sint16 x2, Sint16 y, SDL_T
 \param texture_dx the offset of the texture relative to the screeen. If you move the polygon 10 pixels 
 to the left and want the texture to apear the same you need to increase the texture_dx value
 \param texture_dy see texture_dx
-\param polyInts Preallocated temp array storage for vertex sorting (used for multi-threaded operation)
-\param polyAllocated Flag indicating oif the temp array was allocated (used for multi-threaded operation)
+\param polyInts Preallocated temp array storage for vertex sorting (used for multi-threaded operation); NULL for the per-thread array
+\param polyAllocated Size in ints of the temp array (used for multi-threaded operation); NULL for the per-thread array
 
 \returns Returns 0 on success, -1 on failure.
 */
@@ -3129,8 +4091,6 @@ int texturedPolygonMT(SDL_Renderer *renderer, const Sint16 * vx, const Sint16 *
 	int x2, y2;
 	int ind1, ind2;
 	int ints;
-	int *gfxPrimitivesPolyInts = NULL;
-	int gfxPrimitivesPolyAllocated = 0;
 	SDL_Texture *textureAsTexture = NULL;
 
 	/*
@@ -3144,50 +4104,15 @@ int texturedPolygonMT(SDL_Renderer *renderer, const Sint16 * vx, const Sint16 *
 	* Map polygon cache  
 	*/
 	if ((polyInts==NULL) || (polyAllocated==NULL)) {
-		/* Use global cache */
-		gfxPrimitivesPolyInts = gfxPrimitivesPolyIntsGlobal;
-		gfxPrimitivesPolyAllocated = gfxPrimitivesPolyAllocatedGlobal;
-	} else {
-		/* Use local cache */
-		gfxPrimitivesPolyInts = *polyInts;
-		gfxPrimitivesPolyAllocated = *polyAllocated;
-	}
-
-	/*
-	* Allocate temp array, only grow array 
-	*/
-	if (!gfxPrimitivesPolyAllocated) {
-		gfxPrimitivesPolyInts = (int *) malloc(sizeof(int) * n);
-		gfxPrimitivesPolyAllocated = n;
-	} else {
-		if (gfxPrimitivesPolyAllocated < n) {
-			gfxPrimitivesPolyInts = (int *) realloc(gfxPrimitivesPolyInts, sizeof(int) * n);
-			gfxPrimitivesPolyAllocated = n;
-		}
-	}
-
-	/*
-	* Check temp array
-	*/
-	if (gfxPrimitivesPolyInts==NULL) {        
-		gfxPrimitivesPolyAllocated = 0;
-	}
-
-	/*
-	* Update cache variables
-	*/
-	if ((polyInts==NULL) || (polyAllocated==NULL)) { 
-		gfxPrimitivesPolyIntsGlobal =  gfxPrimitivesPolyInts;
-		gfxPrimitivesPolyAllocatedGlobal = gfxPrimitivesPolyAllocated;
-	} else {
-		*polyInts = gfxPrimitivesPolyInts;
-		*polyAllocated = gfxPrimitivesPolyAllocated;
+		/* Use per-thread cache */
+		polyInts = &gfxPrimitivesPolyIntsThread;
+		polyAllocated = &gfxPrimitivesPolyAllocatedThread;
 	}
 
 	/*
-	* Check temp array again
+	* Grow temp array if needed
 	*/
-	if (gfxPrimitivesPolyInts==NULL) {        
+	if (_gfxPrimitivesPolyReserve(polyInts, polyAllocated, n) != 0) {
 		return(-1);
 	}
 
@@ -3247,16 +4172,16 @@ int texturedPolygonMT(SDL_Renderer *renderer, const Sint16 * vx, const Sint16 *
 				continue;
 			}
 			if ( ((y >= y1) && (y < y2)) || ((y == maxy) && (y > y1) && (y <= y2)) ) {
-				gfxPrimitivesPolyInts[ints++] = ((65536 * (y - y1)) / (y2 - y1)) * (x2 - x1) + (65536 * x1);
+				(*polyInts)[ints++] = ((65536 * (y - y1)) / (y2 - y1)) * (x2 - x1) + (65536 * x1);
 			} 
 		}
 
-		qsort(gfxPrimitivesPolyInts, ints, sizeof(int), _gfxPrimitivesCompareInt);
+		qsort(*polyInts, ints, sizeof(int), _gfxPrimitivesCompareInt);
 
 		for (i = 0; (i < ints); i += 2) {
-			xa = gfxPrimitivesPolyInts[i] + 1;
+			xa = (*polyInts)[i] + 1;
 			xa = (xa >> 16) + ((xa & 32768) >> 15);
-			xb = gfxPrimitivesPolyInts[i+1] - 1;
+			xb = (*polyInts)[i+1] - 1;
 			xb = (xb >> 16) + ((xb & 32768) >> 15);
 			result |= _HLineTextured(renderer, xa, xb, y, textureAsTexture, texture->w, texture->h, texture_dx, texture_dy);
 		}
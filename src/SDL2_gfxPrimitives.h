@@ -66,6 +66,63 @@ extern "C" {
 
 	/* Note: all ___Color routines expect the color to be in format 0xRRGGBBAA */
 
+	/* Batch */
+
+	/* Spans and points sharing one color, submitted with one SDL_RenderFillRects and
+	   one SDL_RenderDrawPoints per flush. About 29 KB: keep it in static or heap storage
+	   rather than on a small stack. Flushes itself when full; every gfxBatchBegin must be
+	   matched by gfxBatchEnd, which releases the buffers of the weighted pixels. */
+
+	/* The software target writes the spans straight into the pixels of a 32-bit
+	   surface (locked from begin to end) or of a raw ARGB8888 framebuffer. */
+
+#define SDL2_GFX_BATCH_SIZE	1024
+
+	typedef struct {
+		SDL_Renderer *renderer;
+		SDL_Surface *surface;
+		SDL_PixelFormat *format;	/* NULL for ARGB8888 */
+		Uint32 *pixels;
+		int pitch;			/* in pixels */
+		SDL_Rect bounds;		/* the whole target */
+		SDL_Rect clip;
+		Uint8 r, g, b, a;
+		int rects, points;
+		int result;
+		SDL_Rect rect[SDL2_GFX_BATCH_SIZE];
+		SDL_Point point[SDL2_GFX_BATCH_SIZE];
+		int weights;			/* pixels with alpha scaled by weight / 256 */
+		Sint16 weightX[SDL2_GFX_BATCH_SIZE];
+		Sint16 weightY[SDL2_GFX_BATCH_SIZE];
+		Uint8 weight[SDL2_GFX_BATCH_SIZE];
+		SDL_Vertex *weightVertices;	/* renderer targets, allocated on first flush */
+		int *weightIndices;
+		int weightCapacity;
+	} SDL2_gfxBatch;
+
+	SDL2_GFXPRIMITIVES_SCOPE void gfxBatchBegin(SDL2_gfxBatch * batch, SDL_Renderer * renderer, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+	SDL2_GFXPRIMITIVES_SCOPE int gfxBatchBeginSurface(SDL2_gfxBatch * batch, SDL_Surface * surface, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+	SDL2_GFXPRIMITIVES_SCOPE void gfxBatchBeginPixels(SDL2_gfxBatch * batch, Uint32 * pixels, int width, int height, int pitch,
+		Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+	SDL2_GFXPRIMITIVES_SCOPE void gfxBatchSetClip(SDL2_gfxBatch * batch, const SDL_Rect * rect);
+	SDL2_GFXPRIMITIVES_SCOPE int gfxBatchColor(SDL2_gfxBatch * batch, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+	SDL2_GFXPRIMITIVES_SCOPE int gfxBatchFlush(SDL2_gfxBatch * batch);
+	SDL2_GFXPRIMITIVES_SCOPE int gfxBatchEnd(SDL2_gfxBatch * batch);
+
+	SDL2_GFXPRIMITIVES_SCOPE int pixelBatch(SDL2_gfxBatch * batch, Sint16 x, Sint16 y);
+	SDL2_GFXPRIMITIVES_SCOPE int pixelWeightBatch(SDL2_gfxBatch * batch, Sint16 x, Sint16 y, Uint8 weight);
+	SDL2_GFXPRIMITIVES_SCOPE int hlineBatch(SDL2_gfxBatch * batch, Sint16 x1, Sint16 x2, Sint16 y);
+	SDL2_GFXPRIMITIVES_SCOPE int vlineBatch(SDL2_gfxBatch * batch, Sint16 x, Sint16 y1, Sint16 y2);
+	SDL2_GFXPRIMITIVES_SCOPE int lineBatch(SDL2_gfxBatch * batch, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2);
+	SDL2_GFXPRIMITIVES_SCOPE int aalineBatch(SDL2_gfxBatch * batch, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2);
+	SDL2_GFXPRIMITIVES_SCOPE int aapolygonBatch(SDL2_gfxBatch * batch, const Sint16 * vx, const Sint16 * vy, int n);
+	SDL2_GFXPRIMITIVES_SCOPE int boxBatch(SDL2_gfxBatch * batch, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2);
+	SDL2_GFXPRIMITIVES_SCOPE int filledCircleBatch(SDL2_gfxBatch * batch, Sint16 x, Sint16 y, Sint16 rad);
+	SDL2_GFXPRIMITIVES_SCOPE int filledEllipseBatch(SDL2_gfxBatch * batch, Sint16 x, Sint16 y, Sint16 rx, Sint16 ry);
+	SDL2_GFXPRIMITIVES_SCOPE int filledTrigonBatch(SDL2_gfxBatch * batch, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Sint16 x3, Sint16 y3);
+	SDL2_GFXPRIMITIVES_SCOPE int filledPolygonBatch(SDL2_gfxBatch * batch, const Sint16 * vx, const Sint16 * vy, int n);
+	SDL2_GFXPRIMITIVES_SCOPE int filledPolygonBatchMT(SDL2_gfxBatch * batch, const Sint16 * vx, const Sint16 * vy, int n, int **polyInts, int *polyAllocated);
+
 	/* Pixel */
 
 	SDL2_GFXPRIMITIVES_SCOPE int pixelColor(SDL_Renderer * renderer, Sint16 x, Sint16 y, Uint32 color);
@@ -213,10 +270,20 @@ extern "C" {
 	SDL2_GFXPRIMITIVES_SCOPE int filledPolygonColor(SDL_Renderer * renderer, const Sint16 * vx, const Sint16 * vy, int n, Uint32 color);
 	SDL2_GFXPRIMITIVES_SCOPE int filledPolygonRGBA(SDL_Renderer * renderer, const Sint16 * vx,
 		const Sint16 * vy, int n, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+	SDL2_GFXPRIMITIVES_SCOPE int filledPolygonRGBAMT(SDL_Renderer * renderer, const Sint16 * vx,
+		const Sint16 * vy, int n, Uint8 r, Uint8 g, Uint8 b, Uint8 a, int **polyInts, int *polyAllocated);
 
 	/* Textured Polygon */
 
 	SDL2_GFXPRIMITIVES_SCOPE int texturedPolygon(SDL_Renderer * renderer, const Sint16 * vx, const Sint16 * vy, int n, SDL_Surface * texture,int texture_dx,int texture_dy);
+	SDL2_GFXPRIMITIVES_SCOPE int texturedPolygonMT(SDL_Renderer * renderer, const Sint16 * vx, const Sint16 * vy, int n,
+		SDL_Surface * texture, int texture_dx, int texture_dy, int **polyInts, int *polyAllocated);
+
+	/* Without their own scratch arrays, polygon calls use one array per thread;
+	   a thread frees its array with gfxPrimitivesPolyFree before exiting (the
+	   weighted pixel buffers of a batch are freed by gfxBatchEnd) */
+
+	SDL2_GFXPRIMITIVES_SCOPE void gfxPrimitivesPolyFree(void);
 
 	/* Bezier */
 
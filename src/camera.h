@@ -0,0 +1,68 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+/* Rectangle du plan du diagramme, en coordonnées du monde */
+struct ViewRect
+{
+    double minX, minY, maxX, maxY;
+
+    bool contains(double x, double y) const
+    {
+        return x >= minX && x <= maxX && y >= minY && y <= maxY;
+    }
+    bool overlaps(double x1, double y1, double x2, double y2) const
+    {
+        return x2 >= minX && x1 <= maxX && y2 >= minY && y1 <= maxY;
+    }
+};
+
+/*
+   Vue sur le plan du diagramme : (x, y) est le point du monde affiché
+   dans le coin haut gauche de la fenêtre, zoom le nombre de pixels par
+   unité du monde.
+*/
+struct Camera
+{
+    double x = 0, y = 0;
+    double zoom = 1;
+
+    double toScreenX(double wx) const { return (wx - x) * zoom; }
+    double toScreenY(double wy) const { return (wy - y) * zoom; }
+    double toWorldX(double sx) const { return x + sx / zoom; }
+    double toWorldY(double sy) const { return y + sy / zoom; }
+
+    /* Partie du monde couverte par une sortie width x height, élargie de margin pixels */
+    ViewRect visible(int width, int height, double margin = 0) const
+    {
+        return ViewRect{
+            toWorldX(-margin), toWorldY(-margin),
+            toWorldX(width + margin), toWorldY(height + margin)};
+    }
+
+    /* Déplace la vue de (dx, dy) pixels écran */
+    void pan(double dx, double dy)
+    {
+        x -= dx / zoom;
+        y -= dy / zoom;
+    }
+
+    /* Change le zoom en gardant fixe le point du monde sous (sx, sy) */
+    void zoomAt(double sx, double sy, double newZoom)
+    {
+        double wx = toWorldX(sx), wy = toWorldY(sy);
+        zoom = newZoom;
+        x = wx - sx / zoom;
+        y = wy - sy / zoom;
+    }
+
+    bool operator==(const Camera& other) const
+    {
+        return x == other.x && y == other.y && zoom == other.zoom;
+    }
+    bool operator!=(const Camera& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+#endif
@@ -0,0 +1,201 @@
+#include "diagram_worker.h"
+
+DiagramWorker::DiagramWorker()
+    : snapshot_(std::make_shared<const Triangulation>())
+{
+    thread_ = std::thread(&DiagramWorker::run, this);
+}
+
+DiagramWorker::~DiagramWorker()
+{
+    stop();
+}
+
+void DiagramWorker::setNotify(std::function<void()> notify)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    notify_ = std::move(notify);
+}
+
+void DiagramWorker::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+        cancel_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void DiagramWorker::push(Command command)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        switch (command.kind)
+        {
+        case Command::CLEAR:
+            queue_.clear();
+            if (running_)
+                cancel_ = true;
+            break;
+        case Command::REBUILD:
+            // Une reconstruction rend caduques celles qui la précèdent
+            for (auto it = queue_.begin(); it != queue_.end();)
+                it = it->kind == Command::REBUILD ? queue_.erase(it) : it + 1;
+            if (running_ && runningKind_ == Command::REBUILD)
+                cancel_ = true;
+            break;
+        case Command::INSERT:
+            // Les insertions qui se suivent forment un seul lot
+            if (!queue_.empty() && queue_.back().kind == Command::INSERT)
+            {
+                std::vector<Site>& batch = queue_.back().sites;
+                batch.insert(batch.end(), command.sites.begin(), command.sites.end());
+                return;
+            }
+            break;
+        case Command::RELAX:
+            if (!queue_.empty() && queue_.back().kind == Command::RELAX)
+                return;
+            break;
+        }
+        queue_.push_back(std::move(command));
+    }
+    wake_.notify_one();
+}
+
+void DiagramWorker::clear(double minX, double minY, double maxX, double maxY)
+{
+    push(Command{Command::CLEAR, minX, minY, maxX, maxY, {}, {}});
+}
+
+void DiagramWorker::rebuild(double minX, double minY, double maxX, double maxY)
+{
+    push(Command{Command::REBUILD, minX, minY, maxX, maxY, {}, {}});
+}
+
+void DiagramWorker::insert(std::vector<Site> sites)
+{
+    if (!sites.empty())
+        push(Command{Command::INSERT, 0, 0, 0, 0, std::move(sites), {}});
+}
+
+void DiagramWorker::relax(LloydSettings settings)
+{
+    push(Command{Command::RELAX, 0, 0, 0, 0, {}, std::move(settings)});
+}
+
+std::shared_ptr<const Triangulation> DiagramWorker::snapshot() const
+{
+    return std::atomic_load(&snapshot_);
+}
+
+void DiagramWorker::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (stopping_)
+            return;
+
+        Command command = std::move(queue_.front());
+        queue_.pop_front();
+        running_ = true;
+        runningKind_ = command.kind;
+        cancel_ = false;
+        lock.unlock();
+
+        bool done = execute(command);
+        if (done)
+            publish();
+
+        lock.lock();
+        running_ = false;
+    }
+}
+
+bool DiagramWorker::execute(Command& command)
+{
+    switch (command.kind)
+    {
+    case Command::CLEAR:
+        sites_.clear();
+        minX_ = command.minX;
+        minY_ = command.minY;
+        maxX_ = command.maxX;
+        maxY_ = command.maxY;
+        diagram_.reset(minX_, minY_, maxX_, maxY_);
+        stale_ = false;
+        return true;
+
+    case Command::REBUILD:
+        minX_ = command.minX;
+        minY_ = command.minY;
+        maxX_ = command.maxX;
+        maxY_ = command.maxY;
+        // Annulée, elle laisse diagram_ dans l'ancien cadre : la commande
+        // suivante doit reconstruire
+        stale_ = !build();
+        return !stale_;
+
+    case Command::INSERT:
+        sites_.insert(sites_.end(), command.sites.begin(), command.sites.end());
+        if (stale_)
+            return build();
+        if (command.sites.size() == 1)
+        {
+            diagram_.insert(command.sites[0]);
+            return true;
+        }
+        // Un lot interrompu laisse une partie des sites hors du diagramme
+        stale_ = !diagram_.insertBatch(std::move(command.sites), nullptr, &cancel_);
+        return !stale_;
+
+    case Command::RELAX:
+        if (stale_ && !build())
+            return false;
+        // Arrêtée entre deux itérations, la relaxation laisse un diagramme
+        // cohérent, dont les sites sont relus ci-dessous
+        command.lloyd.cancel = &cancel_;
+        relaxLloyd(diagram_, command.lloyd);
+        sites_.clear();
+        for (int v = 3; v < diagram_.vertexCount(); v++)
+            sites_.push_back(diagram_.site(v));
+        return !cancel_;
+    }
+    return false;
+}
+
+/*
+   Reconstruit tous les sites dans une triangulation à part, qui ne remplace
+   diagram_ qu'une fois complète : une reconstruction annulée laisse
+   l'ancien diagramme intact.
+*/
+bool DiagramWorker::build()
+{
+    Triangulation next;
+    next.reset(minX_, minY_, maxX_, maxY_);
+    if (!next.insertBatch(sites_, nullptr, &cancel_))
+        return false;
+    diagram_ = std::move(next);
+    stale_ = false;
+    return true;
+}
+
+/* La copie partage ses blocs avec diagram_, seuls ceux modifiés ensuite sont dupliqués */
+void DiagramWorker::publish()
+{
+    std::atomic_store(&snapshot_, std::shared_ptr<const Triangulation>(std::make_shared<Triangulation>(diagram_)));
+
+    std::function<void()> notify;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        notify = notify_;
+    }
+    if (notify)
+        notify();
+}
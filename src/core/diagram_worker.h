@@ -0,0 +1,79 @@
+#ifndef DIAGRAM_WORKER_H
+#define DIAGRAM_WORKER_H
+#include "triangulation.h"
+#include "lloyd.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+   Calcule la triangulation et le diagramme de Voronoi sur un thread dédié.
+   Les commandes sont mises en file ; après chacune, une copie figée du
+   diagramme est publiée et remplace atomiquement la précédente. La copie
+   partage ses blocs avec le diagramme de travail (voir SharedArray). Le
+   thread d'affichage continue de lire l'ancien instantané pendant ce temps.
+*/
+class DiagramWorker
+{
+public:
+    DiagramWorker();
+    DiagramWorker(const DiagramWorker&) = delete;
+    DiagramWorker& operator=(const DiagramWorker&) = delete;
+    ~DiagramWorker();
+
+    /* Appelé depuis le thread de calcul à chaque publication */
+    void setNotify(std::function<void()> notify);
+
+    /* Vide le diagramme : les commandes en attente et le calcul en cours deviennent caducs */
+    void clear(double minX, double minY, double maxX, double maxY);
+    /* Reconstruit tous les sites dans un nouveau cadre, annule une reconstruction en cours */
+    void rebuild(double minX, double minY, double maxX, double maxY);
+    void insert(std::vector<Site> sites);
+    void relax(LloydSettings settings);
+
+    /* Dernier diagramme terminé, jamais nul */
+    std::shared_ptr<const Triangulation> snapshot() const;
+
+    /* Arrête le thread, les commandes en attente sont abandonnées */
+    void stop();
+
+private:
+    struct Command
+    {
+        enum Kind { CLEAR, REBUILD, INSERT, RELAX } kind;
+        double minX, minY, maxX, maxY;
+        std::vector<Site> sites;
+        LloydSettings lloyd;
+    };
+
+    void push(Command command);
+    void run();
+    bool execute(Command& command);
+    bool build();
+    void publish();
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Command> queue_;
+    bool stopping_ = false;
+    bool running_ = false;
+    Command::Kind runningKind_ = Command::CLEAR;
+    std::atomic<bool> cancel_{false};
+    std::function<void()> notify_;
+
+    // Propres au thread de calcul
+    Triangulation diagram_;
+    std::vector<Site> sites_;
+    double minX_ = 0, minY_ = 0, maxX_ = 0, maxY_ = 0;
+    bool stale_ = false; // diagram_ ne contient pas tous les sites_, ou pas dans ce cadre
+
+    std::shared_ptr<const Triangulation> snapshot_;
+    std::thread thread_;
+};
+
+#endif
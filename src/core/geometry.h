@@ -0,0 +1,47 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+struct Coords
+{
+    int x, y;
+
+    bool operator==(const Coords& other) const
+    {
+        return x == other.x && y == other.y;
+    }
+    bool operator!=(const Coords& other) const
+    {
+        return x != other.x || y != other.y;
+    }
+};
+
+struct Segment
+{
+    Coords p1, p2;
+
+    bool operator==(const Segment& other) const
+    {
+        return (p1 == other.p1 && p2 == other.p2)
+        || (p1 == other.p2 && p2 == other.p1);
+    }
+    bool operator!=(const Segment& other) const
+    {
+        return (p1 != other.p1 || p2 != other.p2)
+        && (p1 != other.p2 || p2 != other.p1);
+    }
+};
+
+struct Triangle
+{
+    Coords p1, p2, p3;
+    Segment s1{p1, p2}, s2{p2, p3}, s3{p3, p1};
+    Coords center;
+    float radius;
+
+    bool operator==(const Triangle& other) const
+    {
+        return p1 == other.p1 && p2 == other.p2 && p3 == other.p3;
+    }
+};
+
+#endif
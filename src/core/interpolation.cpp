@@ -0,0 +1,137 @@
+#include "interpolation.h"
+#include "parallel.h"
+#include <cmath>
+
+double NaturalNeighbourInterpolator::interpolate(
+    const Triangulation& diagram, const std::vector<double>& values, double x, double y)
+{
+    int f = diagram.locate(x, y, hintFace_);
+    if (f == Triangulation::NONE)
+        return NAN;
+    hintFace_ = f;
+
+    // Les faces qui touchent le super triangle couvrent l'extérieur de l'enveloppe
+    for (int v: diagram.face(f).v)
+    {
+        if (diagram.isSuper(v))
+            return NAN;
+        const Site& s = diagram.site(v);
+        if (s.x == x && s.y == y)
+            return values[v - 3];
+    }
+
+    Site q{x, y};
+    if (mark_.size() < (std::size_t)diagram.faceCount())
+        mark_.resize(diagram.faceCount(), 0);
+    if (++epoch_ == 0)
+    {
+        std::fill(mark_.begin(), mark_.end(), 0);
+        epoch_ = 1;
+    }
+
+    cavity_.clear();
+    cavity_.push_back(f);
+    mark_[f] = epoch_;
+    for (std::size_t k = 0; k < cavity_.size(); k++)
+    {
+        for (int n: diagram.face(cavity_[k]).adj)
+        {
+            if (n != Triangulation::NONE && mark_[n] != epoch_ && diagram.conflicts(n, q))
+            {
+                mark_[n] = epoch_;
+                cavity_.push_back(n);
+            }
+        }
+    }
+
+    boundary_.clear();
+    for (int g: cavity_)
+    {
+        const Triangulation::Face& t = diagram.face(g);
+        for (int i = 0; i < 3; i++)
+        {
+            int n = t.adj[i];
+            if (n == Triangulation::NONE || mark_[n] != epoch_)
+            {
+                int a = t.v[(i + 1) % 3], b = t.v[(i + 2) % 3];
+                boundary_.push_back(BoundaryEdge{a, b, g, powerCenter(q, diagram.site(a), diagram.site(b))});
+            }
+        }
+    }
+
+    /*
+       Aire volée au voisin v : nouveau centre du côté (u, v), anciens centres
+       des faces de la cavité autour de v, nouveau centre du côté (v, w).
+    */
+    double total = 0, sum = 0;
+    for (const BoundaryEdge& in: boundary_)
+    {
+        int v = in.b;
+        const BoundaryEdge *out = nullptr;
+        for (const BoundaryEdge& e: boundary_)
+        {
+            if (e.a == v)
+                out = &e;
+        }
+        if (!out)
+            continue;
+
+        polygon_.clear();
+        polygon_.push_back(in.center);
+        int g = in.face;
+        for (std::size_t guard = 0; guard <= cavity_.size(); guard++)
+        {
+            polygon_.push_back(diagram.center(g));
+            if (g == out->face)
+                break;
+            const Triangulation::Face& t = diagram.face(g);
+            int i = t.v[0] == v ? 0 : (t.v[1] == v ? 1 : 2);
+            int next = t.adj[(i + 2) % 3];
+            if (next == Triangulation::NONE || mark_[next] != epoch_)
+                break;
+            g = next;
+        }
+        polygon_.push_back(out->center);
+
+        double area = 0;
+        for (std::size_t k = 0; k < polygon_.size(); k++)
+        {
+            const Site& p1 = polygon_[k];
+            const Site& p2 = polygon_[(k + 1) % polygon_.size()];
+            area += p1.x * p2.y - p2.x * p1.y;
+        }
+        area = std::fabs(area) / 2.0;
+
+        if (!diagram.isSuper(v))
+        {
+            total += area;
+            sum += area * values[v - 3];
+        }
+    }
+
+    return total > 0 ? sum / total : NAN;
+}
+
+void interpolateGrid(
+    const Triangulation& diagram, const std::vector<double>& values,
+    double minX, double minY, double maxX, double maxY,
+    int width, int height, std::vector<float>& raster, unsigned threads)
+{
+    raster.assign((std::size_t)width * height, NAN);
+    double dx = (maxX - minX) / width, dy = (maxY - minY) / height;
+
+    parallelFor(height, [&](int begin, int end, unsigned)
+    {
+        NaturalNeighbourInterpolator interpolator;
+        for (int j = begin; j < end; j++)
+        {
+            // Aller-retour d'une ligne à l'autre pour garder la face indice voisine
+            for (int k = 0; k < width; k++)
+            {
+                int i = (j % 2 == 0) ? k : width - 1 - k;
+                raster[(std::size_t)j * width + i] = (float)interpolator.interpolate(
+                    diagram, values, minX + (i + 0.5) * dx, minY + (j + 0.5) * dy);
+            }
+        }
+    }, threads);
+}
@@ -0,0 +1,44 @@
+#ifndef INTERPOLATION_H
+#define INTERPOLATION_H
+#include "triangulation.h"
+#include <vector>
+
+/*
+   Interpolation par voisins naturels de Sibson : la valeur en (x, y) est la
+   moyenne des valeurs des voisins naturels, pondérée par l'aire que la
+   cellule du point de requête leur prendrait. values[k] est la valeur du
+   sommet k + 3. Garder un interpolateur par thread.
+*/
+class NaturalNeighbourInterpolator
+{
+public:
+    /* Retourne NAN hors de l'enveloppe convexe des sites */
+    double interpolate(const Triangulation& diagram, const std::vector<double>& values, double x, double y);
+
+private:
+    struct BoundaryEdge
+    {
+        int a, b, face; // face de la cavité qui porte le côté (a, b)
+        Site center;    // centre de la nouvelle face (requête, a, b)
+    };
+
+    int hintFace_ = Triangulation::NONE;
+    std::vector<unsigned> mark_;
+    unsigned epoch_ = 0;
+    std::vector<int> cavity_;
+    std::vector<BoundaryEdge> boundary_;
+    std::vector<Site> polygon_;
+};
+
+/*
+   Remplit raster (width x height, ligne par ligne) avec l'interpolation au
+   centre de chaque pixel du cadre [minX, maxX] x [minY, maxY]. Les lignes
+   sont réparties entre les threads.
+*/
+void interpolateGrid(
+    const Triangulation& diagram, const std::vector<double>& values,
+    double minX, double minY, double maxX, double maxY,
+    int width, int height, std::vector<float>& raster, unsigned threads = 0
+);
+
+#endif
@@ -0,0 +1,118 @@
+#include "lloyd.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /* Sutherland-Hodgman contre un demi-plan axial */
+    template <typename Inside, typename Cut>
+    void clipEdge(const std::vector<Site>& in, std::vector<Site>& out, Inside inside, Cut cut)
+    {
+        out.clear();
+        for (std::size_t k = 0; k < in.size(); k++)
+        {
+            const Site& a = in[k];
+            const Site& b = in[(k + 1) % in.size()];
+            bool ina = inside(a), inb = inside(b);
+            if (ina)
+                out.push_back(a);
+            if (ina != inb)
+                out.push_back(cut(a, b));
+        }
+    }
+
+    void clipToBox(std::vector<Site>& polygon, std::vector<Site>& scratch, const LloydSettings& s)
+    {
+        auto atX = [](double x)
+        {
+            return [x](const Site& a, const Site& b)
+            {
+                double t = (x - a.x) / (b.x - a.x);
+                return Site{x, a.y + t * (b.y - a.y)};
+            };
+        };
+        auto atY = [](double y)
+        {
+            return [y](const Site& a, const Site& b)
+            {
+                double t = (y - a.y) / (b.y - a.y);
+                return Site{a.x + t * (b.x - a.x), y};
+            };
+        };
+        clipEdge(polygon, scratch, [&](const Site& p) { return p.x >= s.minX; }, atX(s.minX));
+        clipEdge(scratch, polygon, [&](const Site& p) { return p.x <= s.maxX; }, atX(s.maxX));
+        clipEdge(polygon, scratch, [&](const Site& p) { return p.y >= s.minY; }, atY(s.minY));
+        clipEdge(scratch, polygon, [&](const Site& p) { return p.y <= s.maxY; }, atY(s.maxY));
+    }
+}
+
+std::vector<LloydIteration> relaxLloyd(Triangulation& diagram, const LloydSettings& settings)
+{
+    std::vector<LloydIteration> history;
+    int n = diagram.siteCount();
+    if (n == 0)
+        return history;
+
+    unsigned threads = settings.threads ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<Site> centroids(n);
+    std::vector<double> energy(threads), displacement(threads);
+
+    for (int iteration = 0; iteration < settings.maxIterations; iteration++)
+    {
+        if (settings.cancel && settings.cancel->load(std::memory_order_relaxed))
+            break;
+
+        std::fill(energy.begin(), energy.end(), 0.0);
+        std::fill(displacement.begin(), displacement.end(), 0.0);
+
+        parallelFor(n, [&](int begin, int end, unsigned worker)
+        {
+            std::vector<Site> polygon, scratch;
+            double e = 0, d = 0;
+            for (int k = begin; k < end; k++)
+            {
+                const Site& s = diagram.site(k + 3);
+                diagram.cell(k + 3, polygon);
+                clipToBox(polygon, scratch, settings);
+
+                // Découpe en triangles (s, p_i, p_i+1) : aire, centroïde et moment d'inertie
+                double area = 0, cx = 0, cy = 0;
+                for (std::size_t i = 0; i < polygon.size(); i++)
+                {
+                    double ux = polygon[i].x - s.x, uy = polygon[i].y - s.y;
+                    const Site& q = polygon[(i + 1) % polygon.size()];
+                    double wx = q.x - s.x, wy = q.y - s.y;
+                    double a = (ux * wy - uy * wx) / 2.0;
+                    area += a;
+                    cx += a * (ux + wx) / 3.0;
+                    cy += a * (uy + wy) / 3.0;
+                    e += a * (ux * ux + ux * wx + wx * wx + uy * uy + uy * wy + wy * wy) / 6.0;
+                }
+
+                if (area > 0)
+                    centroids[k] = Site{s.x + cx / area, s.y + cy / area};
+                else
+                    centroids[k] = s;
+                d = std::max(d, std::hypot(centroids[k].x - s.x, centroids[k].y - s.y));
+            }
+            energy[worker] = e;
+            displacement[worker] = d;
+        }, threads);
+
+        LloydIteration it{0, 0, true};
+        for (unsigned w = 0; w < threads; w++)
+        {
+            it.energy += energy[w];
+            it.maxDisplacement = std::max(it.maxDisplacement, displacement[w]);
+        }
+        it.kinetic = diagram.moveSites(centroids);
+        history.push_back(it);
+        if (settings.onIteration)
+            settings.onIteration(iteration, it);
+
+        if (it.maxDisplacement < settings.tolerance)
+            break;
+    }
+    return history;
+}
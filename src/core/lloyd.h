@@ -0,0 +1,36 @@
+#ifndef LLOYD_H
+#define LLOYD_H
+#include "triangulation.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+
+struct LloydIteration
+{
+    double energy;                 // somme des moments d'inertie des cellules
+    double maxDisplacement;
+    bool kinetic;                  // false si la triangulation a été reconstruite
+};
+
+struct LloydSettings
+{
+    double minX, minY, maxX, maxY; // cadre de découpe des cellules
+    int maxIterations = 50;
+    double tolerance = 0.01;       // arrêt quand aucun site ne bouge plus que ça
+    unsigned threads = 0;          // 0 : un par cœur
+
+    // Appelé après chaque itération, depuis le thread appelant
+    std::function<void(int, const LloydIteration&)> onIteration;
+    // Vérifié entre deux itérations
+    const std::atomic<bool> *cancel = nullptr;
+};
+
+/*
+   Relaxation de Lloyd (diagramme de Voronoi centroïdal) : chaque site est
+   déplacé au centroïde de sa cellule découpée par le cadre, puis la
+   triangulation est réparée par bascules au lieu d'être reconstruite.
+   Retourne l'énergie de chaque itération.
+*/
+std::vector<LloydIteration> relaxLloyd(Triangulation& diagram, const LloydSettings& settings);
+
+#endif
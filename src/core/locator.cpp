@@ -0,0 +1,155 @@
+#include "locator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    double power(const Site& s, double x, double y)
+    {
+        return (s.x - x) * (s.x - x) + (s.y - y) * (s.y - y) - s.w;
+    }
+}
+
+int SiteLocator::descend(const Triangulation& diagram, int v, double x, double y) const
+{
+    double best = power(diagram.site(v), x, y);
+    for (;;)
+    {
+        int next = v;
+        int start = diagram.incidentFace(v);
+        int f = start;
+        do
+        {
+            const Triangulation::Face& t = diagram.face(f);
+            int i = t.v[0] == v ? 0 : (t.v[1] == v ? 1 : 2);
+            int u = t.v[(i + 1) % 3];
+            if (!diagram.isSuper(u))
+            {
+                double d = power(diagram.site(u), x, y);
+                if (d < best)
+                {
+                    best = d;
+                    next = u;
+                }
+            }
+            f = t.adj[(i + 1) % 3];
+        } while (f != start && f != Triangulation::NONE);
+
+        if (next == v)
+            return v;
+        v = next;
+    }
+}
+
+void SiteLocator::prepare(const Triangulation& diagram)
+{
+    if (gridOf_ == &diagram && gridVersion_ == diagram.version())
+        return;
+    gridOf_ = &diagram;
+    gridVersion_ = diagram.version();
+
+    double minX = 0, minY = 0, maxX = 0, maxY = 0;
+    bool first = true;
+    for (int v = 3; v < diagram.vertexCount(); v++)
+    {
+        const Site& s = diagram.site(v);
+        if (first)
+        {
+            minX = maxX = s.x;
+            minY = maxY = s.y;
+            first = false;
+        }
+        minX = std::min(minX, s.x);
+        maxX = std::max(maxX, s.x);
+        minY = std::min(minY, s.y);
+        maxY = std::max(maxY, s.y);
+    }
+
+    // Environ quatre sites par case
+    gridSize_ = std::max(1, (int)std::sqrt(diagram.siteCount() / 4.0));
+    gridX_ = minX;
+    gridY_ = minY;
+    gridScale_ = gridSize_ / std::max({maxX - minX, maxY - minY, 1e-9});
+    grid_.assign((std::size_t)gridSize_ * gridSize_, Triangulation::NONE);
+    for (int v = 3; v < diagram.vertexCount(); v++)
+    {
+        if (diagram.isHidden(v))
+            continue;
+        const Site& s = diagram.site(v);
+        int gx = std::clamp((int)((s.x - gridX_) * gridScale_), 0, gridSize_ - 1);
+        int gy = std::clamp((int)((s.y - gridY_) * gridScale_), 0, gridSize_ - 1);
+        grid_[(std::size_t)gy * gridSize_ + gx] = v;
+    }
+}
+
+int SiteLocator::gridHint(const Triangulation& diagram, double x, double y) const
+{
+    int gx = std::clamp((int)((x - gridX_) * gridScale_), 0, gridSize_ - 1);
+    int gy = std::clamp((int)((y - gridY_) * gridScale_), 0, gridSize_ - 1);
+    int v = grid_[(std::size_t)gy * gridSize_ + gx];
+    return v == Triangulation::NONE ? hintFace_ : diagram.incidentFace(v);
+}
+
+int SiteLocator::nearestSite(const Triangulation& diagram, double x, double y)
+{
+    if (diagram.siteCount() == 0)
+        return Triangulation::NONE;
+    prepare(diagram);
+
+    // La face précédente ne sert que si la requête reste dans les parages
+    int hint = hintFace_;
+    if (hintVertex_ == Triangulation::NONE || hintVertex_ >= diagram.vertexCount()
+        || power(diagram.site(hintVertex_), x, y) * gridScale_ * gridScale_ > 4.0)
+        hint = gridHint(diagram, x, y);
+
+    int start = Triangulation::NONE;
+    int f = diagram.locate(x, y, hint);
+    if (f != Triangulation::NONE)
+    {
+        hintFace_ = f;
+        double best = 0;
+        for (int v: diagram.face(f).v)
+        {
+            double d = power(diagram.site(v), x, y);
+            if (!diagram.isSuper(v) && (start == Triangulation::NONE || d < best))
+            {
+                start = v;
+                best = d;
+            }
+        }
+    }
+    if (start == Triangulation::NONE)
+        start = hintVertex_;
+    if (start == Triangulation::NONE || start >= diagram.vertexCount() || diagram.isHidden(start))
+    {
+        // Toute la face touche le super triangle : on part du premier site visible
+        for (start = 3; diagram.isHidden(start); start++)
+            ;
+    }
+
+    hintVertex_ = descend(diagram, start, x, y);
+    return hintVertex_;
+}
+
+void SiteLocator::nearestSites(const Triangulation& diagram, const Site *queries, std::size_t count, int *sites)
+{
+    if (count == 0)
+        return;
+
+    sites[0] = nearestSite(diagram, queries[0].x, queries[0].y);
+    if (sites[0] == Triangulation::NONE)
+    {
+        for (std::size_t k = 1; k < count; k++)
+            sites[k] = Triangulation::NONE;
+        return;
+    }
+
+    int v = sites[0];
+    for (std::size_t k = 1; k < count; k++)
+    {
+        v = descend(diagram, v, queries[k].x, queries[k].y);
+        sites[k] = v;
+    }
+    hintVertex_ = v;
+    hintFace_ = diagram.incidentFace(v);
+}
@@ -0,0 +1,41 @@
+#ifndef LOCATOR_H
+#define LOCATOR_H
+#include "triangulation.h"
+#include <cstddef>
+#include <vector>
+
+/*
+   Requêtes de site le plus proche (au sens de la puissance pour des sites
+   pondérés) : marche depuis une face indice puis descente gloutonne sur les
+   voisins de Delaunay. Les indices viennent de la requête précédente ou
+   d'une grille grossière de sites. Garder un localisateur par thread.
+*/
+class SiteLocator
+{
+public:
+    /* Retourne le sommet dont la cellule contient (x, y), ou NONE s'il n'y a aucun site */
+    int nearestSite(const Triangulation& diagram, double x, double y);
+
+    /*
+       Version par lot : chaque requête part de la réponse précédente,
+       ce qui rend les requêtes voisines presque gratuites.
+    */
+    void nearestSites(const Triangulation& diagram, const Site *queries, std::size_t count, int *sites);
+
+private:
+    int descend(const Triangulation& diagram, int v, double x, double y) const;
+    void prepare(const Triangulation& diagram);
+    int gridHint(const Triangulation& diagram, double x, double y) const;
+
+    int hintFace_ = Triangulation::NONE;
+    int hintVertex_ = Triangulation::NONE;
+
+    // Un site par case, reconstruite quand la version du diagramme change
+    const Triangulation *gridOf_ = nullptr;
+    unsigned gridVersion_ = 0;
+    int gridSize_ = 0;
+    double gridX_ = 0, gridY_ = 0, gridScale_ = 0;
+    std::vector<int> grid_;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/*
+   Découpe [0, count) en tranches contiguës, une par thread.
+   body(begin, end, worker) est appelé depuis chaque thread.
+*/
+template <typename Body>
+void parallelFor(int count, Body body, unsigned threads = 0)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min<unsigned>(threads, std::max(count, 1));
+
+    if (threads <= 1)
+    {
+        body(0, count, 0u);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    int chunk = (count + (int)threads - 1) / (int)threads;
+    for (unsigned w = 1; w < threads; w++)
+    {
+        int begin = std::min(count, (int)w * chunk);
+        int end = std::min(count, begin + chunk);
+        workers.emplace_back(body, begin, end, w);
+    }
+    body(0, std::min(count, chunk), 0u);
+    for (std::thread& t: workers)
+        t.join();
+}
+
+#endif
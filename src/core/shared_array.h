@@ -0,0 +1,85 @@
+#ifndef SHARED_ARRAY_H
+#define SHARED_ARRAY_H
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/*
+   Tableau découpé en blocs de taille fixe tenus par shared_ptr. Une copie
+   ne duplique que la table des blocs, qu'elle partage avec l'original ;
+   un bloc partagé n'est recopié qu'à sa première écriture (edit). Une
+   copie figée reste donc bon marché à publier et à garder pendant que
+   l'original continue d'être modifié sur un autre thread.
+*/
+template <typename T>
+class SharedArray
+{
+public:
+    static constexpr std::size_t CHUNK_BITS = 8;
+    static constexpr std::size_t CHUNK = std::size_t(1) << CHUNK_BITS;
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const T& operator[](std::size_t i) const { return (*chunks_[i >> CHUNK_BITS])[i & (CHUNK - 1)]; }
+    const T& back() const { return (*this)[size_ - 1]; }
+
+    /* Accès en écriture : le bloc de i est d'abord rendu propre à ce tableau */
+    T& edit(std::size_t i) { return own(i >> CHUNK_BITS)[i & (CHUNK - 1)]; }
+
+    void push_back(const T& value)
+    {
+        if ((size_ & (CHUNK - 1)) == 0)
+            chunks_.push_back(std::make_shared<Chunk>());
+        size_++;
+        edit(size_ - 1) = value;
+    }
+
+    void pop_back()
+    {
+        size_--;
+        if ((size_ & (CHUNK - 1)) == 0)
+            chunks_.pop_back();
+    }
+
+    void clear()
+    {
+        chunks_.clear();
+        size_ = 0;
+    }
+
+    void resize(std::size_t count, const T& value = T())
+    {
+        while (size_ > count)
+            pop_back();
+        while (size_ < count)
+            push_back(value);
+    }
+
+    void assign(std::size_t count, const T& value)
+    {
+        clear();
+        resize(count, value);
+    }
+
+private:
+    using Chunk = std::array<T, CHUNK>;
+
+    Chunk& own(std::size_t c)
+    {
+        // Les copies relâchent leurs blocs depuis d'autres threads : la
+        // barrière ordonne leurs dernières lectures avant nos écritures
+        if (chunks_[c].use_count() == 1)
+            std::atomic_thread_fence(std::memory_order_acquire);
+        else
+            chunks_[c] = std::make_shared<Chunk>(*chunks_[c]);
+        return *chunks_[c];
+    }
+
+    std::vector<std::shared_ptr<Chunk>> chunks_;
+    std::size_t size_ = 0;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "spatial_index.h"
+#include <cmath>
+
+namespace
+{
+    // Un niveau de plus dès que l'occupation moyenne du plus fin dépasse MAX_LOAD
+    const int MAX_LOAD = 2;
+    const int MAX_DEPTH = 10;
+}
+
+void SpatialIndex::reset(double minX, double minY, double maxX, double maxY, int expected, int maxKey)
+{
+    originX_ = minX;
+    originY_ = minY;
+    width_ = std::max(maxX - minX, 1.0);
+    height_ = std::max(maxY - minY, 1.0);
+    std::size_t keys = std::max<std::size_t>(maxKey, entries_.size());
+    entries_.assign(keys, Entry());
+    count_ = 0;
+    depth_ = 0;
+    while (depth_ < MAX_DEPTH && expected > MAX_LOAD << (2 * depth_))
+        depth_++;
+    heads_.assign(levelStart(depth_ + 1), NONE);
+}
+
+void SpatialIndex::link(int key)
+{
+    Entry& e = entries_.edit(key);
+    const Box& b = e.box;
+
+    // Niveau le plus fin dont les cases contiennent la boîte :
+    // width_ / 2^level >= largeur, soit level <= log2(width_ / largeur)
+    double ratio = std::min(width_ / (b.maxX - b.minX), height_ / (b.maxY - b.minY));
+    int level = ratio >= (1 << depth_) ? depth_ : std::max(std::ilogb(ratio), 0);
+
+    int side = 1 << level;
+    int cx = (int)std::clamp(((b.minX + b.maxX) / 2 - originX_) * side / width_, 0.0, side - 1.0);
+    int cy = (int)std::clamp(((b.minY + b.maxY) / 2 - originY_) * side / height_, 0.0, side - 1.0);
+    e.cell = levelStart(level) + cy * side + cx;
+    e.next = heads_[e.cell];
+    heads_.edit(e.cell) = key;
+}
+
+/* Les listes sont courtes : le prédécesseur est retrouvé en la parcourant */
+void SpatialIndex::unlink(int key)
+{
+    int cell = entries_[key].cell, next = entries_[key].next;
+    int previous = NONE;
+    for (int k = heads_[cell]; k != key; k = entries_[k].next)
+        previous = k;
+    if (previous == NONE)
+        heads_.edit(cell) = next;
+    else
+        entries_.edit(previous).next = next;
+    entries_.edit(key).cell = NONE;
+}
+
+/* Ajoute un niveau et redistribue tout, amorti par le quadruplement */
+void SpatialIndex::deepen()
+{
+    depth_++;
+    heads_.assign(levelStart(depth_ + 1), NONE);
+    for (int key = 0; key < (int)entries_.size(); key++)
+    {
+        if (entries_[key].cell != NONE)
+            link(key);
+    }
+}
+
+void SpatialIndex::insert(int key, const Box& box)
+{
+    if (key >= (int)entries_.size())
+        entries_.resize(std::max<std::size_t>(key + 1, 2 * entries_.size()));
+    else if (entries_[key].cell != NONE)
+        remove(key);
+
+    entries_.edit(key).box = box;
+    count_++;
+    link(key);
+    if (depth_ < MAX_DEPTH && count_ > MAX_LOAD << (2 * depth_))
+        deepen();
+}
+
+void SpatialIndex::remove(int key)
+{
+    if (!contains(key))
+        return;
+    unlink(key);
+    count_--;
+}
@@ -0,0 +1,97 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+#include "shared_array.h"
+#include <algorithm>
+
+/*
+   Quadtree lâche de boîtes englobantes, repérées par une clé entière
+   stable choisie par l'appelant (petite, car elle sert d'indice). Une
+   boîte va au niveau le plus fin dont les cases sont au moins aussi
+   grandes qu'elle, dans la case de son centre : ajout et retrait en temps
+   constant en moyenne, requêtes en O(niveaux + résultats). Les cases sont
+   des listes chaînées dans des tableaux par blocs partagés : une copie
+   partage tout avec l'original jusqu'à ses prochaines écritures.
+*/
+class SpatialIndex
+{
+public:
+    struct Box
+    {
+        float minX, minY, maxX, maxY;
+    };
+
+    SpatialIndex() { heads_.push_back(NONE); }
+
+    /*
+       Vide l'index, qui couvre désormais le rectangle donné. expected
+       dimensionne d'avance pour un chargement en bloc, et maxKey les
+       tableaux indicés par clé.
+    */
+    void reset(double minX, double minY, double maxX, double maxY, int expected = 0, int maxKey = 0);
+
+    int size() const { return count_; }
+    bool contains(int key) const { return key < (int)entries_.size() && entries_[key].cell != NONE; }
+
+    void insert(int key, const Box& box);
+    void remove(int key);
+
+    /* Appelle visit(key) une fois par élément dont la boîte touche le rectangle */
+    template<typename Visit>
+    void query(double minX, double minY, double maxX, double maxY, Visit visit) const
+    {
+        for (int level = 0; level <= depth_; level++)
+        {
+            // Une boîte déborde de sa case d'au plus une demi-case
+            int side = 1 << level;
+            double cellW = width_ / side, cellH = height_ / side;
+            int x0 = cellIndex(minX - cellW / 2 - originX_, cellW, side);
+            int x1 = cellIndex(maxX + cellW / 2 - originX_, cellW, side);
+            int y0 = cellIndex(minY - cellH / 2 - originY_, cellH, side);
+            int y1 = cellIndex(maxY + cellH / 2 - originY_, cellH, side);
+            for (int cy = y0; cy <= y1; cy++)
+            {
+                for (int cx = x0; cx <= x1; cx++)
+                {
+                    for (int key = heads_[levelStart(level) + cy * side + cx]; key != NONE; key = entries_[key].next)
+                    {
+                        if (overlaps(entries_[key].box, minX, minY, maxX, maxY))
+                            visit(key);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr int NONE = -1;
+
+    struct Entry
+    {
+        Box box;
+        int cell = NONE; // indice dans heads_, NONE hors de l'index
+        int next = NONE;
+    };
+
+    static bool overlaps(const Box& b, double minX, double minY, double maxX, double maxY)
+    {
+        return b.maxX >= minX && b.minX <= maxX && b.maxY >= minY && b.minY <= maxY;
+    }
+    static int cellIndex(double offset, double cellSize, int side)
+    {
+        return (int)std::clamp(offset / cellSize, 0.0, (double)(side - 1));
+    }
+    /* Les niveaux sont rangés l'un après l'autre : (4^level - 1) / 3 cases avant level */
+    static int levelStart(int level) { return ((1 << (2 * level)) - 1) / 3; }
+
+    void link(int key);
+    void unlink(int key);
+    void deepen();
+
+    double originX_ = 0, originY_ = 0, width_ = 1, height_ = 1;
+    int depth_ = 0;
+    int count_ = 0;
+    SharedArray<int> heads_;
+    SharedArray<Entry> entries_; // par clé
+};
+
+#endif
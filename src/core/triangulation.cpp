@@ -0,0 +1,731 @@
+#include "triangulation.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    double orient(const Site& a, const Site& b, double x, double y)
+    {
+        return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+    }
+
+    /* Les centres des faces du bord partent loin : on borne avant la conversion en int */
+    Coords toCoords(const Site& s)
+    {
+        const double limit = 1 << 24;
+        return Coords{
+            (int)std::lround(std::clamp(s.x, -limit, limit)),
+            (int)std::lround(std::clamp(s.y, -limit, limit))
+        };
+    }
+
+    SpatialIndex::Box boxOf(const Segment& s)
+    {
+        return SpatialIndex::Box{
+            (float)std::min(s.p1.x, s.p2.x), (float)std::min(s.p1.y, s.p2.y),
+            (float)std::max(s.p1.x, s.p2.x), (float)std::max(s.p1.y, s.p2.y)};
+    }
+
+    SpatialIndex::Box boxOf(const Site& a, const Site& b, const Site& c)
+    {
+        return SpatialIndex::Box{
+            (float)std::min({a.x, b.x, c.x}), (float)std::min({a.y, b.y, c.y}),
+            (float)std::max({a.x, b.x, c.x}), (float)std::max({a.y, b.y, c.y})};
+    }
+
+    /* Indice sur la courbe de Hilbert d'une grille 2^16 x 2^16 */
+    uint64_t hilbertIndex(uint32_t x, uint32_t y)
+    {
+        uint64_t d = 0;
+        for (uint32_t s = 1u << 15; s > 0; s >>= 1)
+        {
+            uint32_t rx = (x & s) ? 1 : 0;
+            uint32_t ry = (y & s) ? 1 : 0;
+            d += (uint64_t)s * s * ((3 * rx) ^ ry);
+            if (ry == 0)
+            {
+                if (rx == 1)
+                {
+                    x = s - 1 - x;
+                    y = s - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return d;
+    }
+
+    /* Indices des sites triés le long de la courbe de Hilbert du rectangle */
+    std::vector<int> hilbertOrder(const std::vector<Site>& sites,
+        double minX, double minY, double maxX, double maxY)
+    {
+        double sx = 65535.0 / std::max(maxX - minX, 1.0);
+        double sy = 65535.0 / std::max(maxY - minY, 1.0);
+        std::vector<std::pair<uint64_t, int>> keys;
+        keys.reserve(sites.size());
+        for (std::size_t k = 0; k < sites.size(); k++)
+        {
+            uint32_t hx = (uint32_t)std::clamp((sites[k].x - minX) * sx, 0.0, 65535.0);
+            uint32_t hy = (uint32_t)std::clamp((sites[k].y - minY) * sy, 0.0, 65535.0);
+            keys.push_back({hilbertIndex(hx, hy), (int)k});
+        }
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<int> order;
+        order.reserve(keys.size());
+        for (const auto& key: keys)
+            order.push_back(key.second);
+        return order;
+    }
+}
+
+/*
+   Centre radical des trois cercles de puissance : point de même
+   distance de puissance |x - s|^2 - w aux trois sites.
+   Sans poids, c'est le centre du cercle circonscrit.
+*/
+Site powerCenter(const Site& a, const Site& b, const Site& c)
+{
+    double bx = b.x - a.x, by = b.y - a.y;
+    double cx = c.x - a.x, cy = c.y - a.y;
+    double d = 2.0 * (bx * cy - by * cx);
+    if (std::fabs(d) < 1e-12)
+        return Site{(a.x + b.x + c.x) / 3.0, (a.y + b.y + c.y) / 3.0};
+    double b2 = bx * bx + by * by - b.w + a.w;
+    double c2 = cx * cx + cy * cy - c.w + a.w;
+    return Site{a.x + (cy * b2 - by * c2) / d, a.y + (bx * c2 - cx * b2) / d};
+}
+
+void Triangulation::reset(double minX, double minY, double maxX, double maxY)
+{
+    double cx = (minX + maxX) / 2.0, cy = (minY + maxY) / 2.0;
+    double d = std::max({maxX - minX, maxY - minY, 1.0});
+    double m = 10.0 * d;
+    version_++;
+    minX_ = minX;
+    minY_ = minY;
+    maxX_ = maxX;
+    maxY_ = maxY;
+
+    sites_.clear();
+    sites_.push_back(Site{cx - m, cy - m});
+    sites_.push_back(Site{cx + m, cy - m});
+    sites_.push_back(Site{cx, cy + m});
+    vertexFace_.assign(3, 0);
+    faces_.clear();
+    faces_.push_back(Face{{0, 1, 2}, {NONE, NONE, NONE}, true});
+    centers_.clear();
+    centers_.push_back(powerCenter(sites_[0], sites_[1], sites_[2]));
+    freeFaces_.clear();
+    lastFace_ = 0;
+
+    segments_.clear();
+    segmentEdge_.clear();
+    edgeSlot_.assign(3, NONE);
+    triangles_.clear();
+    triangleFace_.clear();
+    faceSlot_.assign(1, NONE);
+    segmentIndex_.reset(minX, minY, maxX, maxY);
+    triangleIndex_.reset(minX, minY, maxX, maxY);
+}
+
+/*
+   Test de puissance : le point relevé (x, y, x^2 + y^2 - w) passe sous le
+   plan des sommets relevés de f. Sans poids, c'est le test du cercle
+   circonscrit.
+*/
+bool Triangulation::conflicts(int f, const Site& p) const
+{
+    const Face& t = faces_[f];
+    const Site& a = sites_[t.v[0]];
+    const Site& b = sites_[t.v[1]];
+    const Site& c = sites_[t.v[2]];
+    double adx = a.x - p.x, ady = a.y - p.y;
+    double bdx = b.x - p.x, bdy = b.y - p.y;
+    double cdx = c.x - p.x, cdy = c.y - p.y;
+    double det = (adx * adx + ady * ady - a.w + p.w) * (bdx * cdy - cdx * bdy)
+        + (bdx * bdx + bdy * bdy - b.w + p.w) * (cdx * ady - adx * cdy)
+        + (cdx * cdx + cdy * cdy - c.w + p.w) * (adx * bdy - bdx * ady);
+    return det > 0;
+}
+
+int Triangulation::locate(double x, double y, int hint) const
+{
+    if (faces_.empty())
+        return NONE;
+
+    int f = hint;
+    if (f == NONE || f >= (int)faces_.size() || !faces_[f].alive)
+        f = lastFace_;
+
+    // La rotation du premier côté testé évite de tourner en rond
+    int r = 0;
+    for (std::size_t step = 0; step <= faces_.size(); step++)
+    {
+        const Face& t = faces_[f];
+        int next = f;
+        for (int k = 0; k < 3; k++)
+        {
+            int i = (k + r) % 3;
+            if (orient(sites_[t.v[(i + 1) % 3]], sites_[t.v[(i + 2) % 3]], x, y) < 0)
+            {
+                next = t.adj[i];
+                break;
+            }
+        }
+        if (next == f)
+            return f;
+        if (next == NONE)
+            return NONE;
+        f = next;
+        r = (r + 1) % 3;
+    }
+
+    // Marche dégénérée : parcours complet
+    for (int g = 0; g < (int)faces_.size(); g++)
+    {
+        const Face& t = faces_[g];
+        if (t.alive
+            && orient(sites_[t.v[0]], sites_[t.v[1]], x, y) >= 0
+            && orient(sites_[t.v[1]], sites_[t.v[2]], x, y) >= 0
+            && orient(sites_[t.v[2]], sites_[t.v[0]], x, y) >= 0)
+            return g;
+    }
+    return NONE;
+}
+
+int Triangulation::allocFace()
+{
+    if (!freeFaces_.empty())
+    {
+        int f = freeFaces_.back();
+        freeFaces_.pop_back();
+        return f;
+    }
+    faces_.push_back(Face{{NONE, NONE, NONE}, {NONE, NONE, NONE}, false});
+    centers_.push_back(Site{0, 0});
+    faceSlot_.push_back(NONE);
+    edgeSlot_.resize(edgeSlot_.size() + 3, NONE);
+    return (int)faces_.size() - 1;
+}
+
+/*
+   Face d'où creuser la cavité de s, ou NONE si s est hors du super triangle
+   ou confondu avec un sommet au moins aussi lourd (rendu dans *duplicate).
+   Confondu avec un sommet plus léger, s le domine : la cavité l'absorbe
+*/
+int Triangulation::locateFree(const Site& s, int *duplicate) const
+{
+    int f = locate(s.x, s.y, lastFace_);
+    if (f == NONE)
+        return NONE;
+    for (int v: faces_[f].v)
+    {
+        if (sites_[v].x == s.x && sites_[v].y == s.y && sites_[v].w >= s.w)
+        {
+            *duplicate = v;
+            return NONE;
+        }
+    }
+    return f;
+}
+
+int Triangulation::insert(const Site& s, VoronoiChangeSet *changes)
+{
+    int duplicate = NONE;
+    int f = locateFree(s, &duplicate);
+    if (f == NONE)
+        return duplicate;
+
+    version_++;
+    int p = (int)sites_.size();
+    sites_.push_back(s);
+    vertexFace_.push_back(NONE);
+    insertVertex(p, f, changes);
+    return p;
+}
+
+/* Creuse la cavité du sommet p, déjà dans sites_, à partir de la face f qui le contient */
+void Triangulation::insertVertex(int p, int f, VoronoiChangeSet *changes)
+{
+    const Site s = sites_[p];
+    Scratch& w = scratch_;
+
+    // Site dominé par ses voisins : il n'a pas de cellule
+    if (!conflicts(f, s))
+        return;
+
+    // Cavité : faces en conflit avec p
+    w.mark.resize(faces_.size(), 0);
+    ++w.epoch;
+    w.cavity.clear();
+    w.cavity.push_back(f);
+    w.mark[f] = w.epoch;
+    for (std::size_t k = 0; k < w.cavity.size(); k++)
+    {
+        const Face& t = faces_[w.cavity[k]];
+        for (int n: t.adj)
+        {
+            if (n != NONE && w.mark[n] != w.epoch && conflicts(n, s))
+            {
+                w.mark[n] = w.epoch;
+                w.cavity.push_back(n);
+            }
+        }
+    }
+
+    w.boundary.clear();
+    for (int g: w.cavity)
+    {
+        const Face& t = faces_[g];
+        for (int i = 0; i < 3; i++)
+        {
+            int n = t.adj[i];
+            if (n == NONE || w.mark[n] != w.epoch)
+                w.boundary.push_back(BoundaryEdge{t.v[(i + 1) % 3], t.v[(i + 2) % 3], n});
+        }
+    }
+
+    for (int g: w.cavity)
+    {
+        for (int v: faces_[g].v)
+            vertexFace_.edit(v) = NONE;
+        for (int i = 0; i < 3; i++)
+            removeEdge(g, i, changes);
+        removeTriangle(g);
+        faces_.edit(g).alive = false;
+        freeFaces_.push_back(g);
+    }
+
+    // Éventail autour de p sur le bord de la cavité
+    w.startAt.resize(sites_.size(), NONE);
+    std::size_t first = w.cavity.size();
+    for (const BoundaryEdge& e: w.boundary)
+    {
+        int nf = allocFace();
+        faces_.edit(nf) = Face{{p, e.a, e.b}, {e.outside, NONE, NONE}, true};
+        centers_.edit(nf) = powerCenter(s, sites_[e.a], sites_[e.b]);
+        if (e.outside != NONE)
+        {
+            Face& o = faces_.edit(e.outside);
+            for (int j = 0; j < 3; j++)
+            {
+                if (o.v[j] != e.a && o.v[j] != e.b)
+                    o.adj[j] = nf;
+            }
+        }
+        w.startAt[e.a] = nf;
+        vertexFace_.edit(e.a) = nf;
+        vertexFace_.edit(e.b) = nf;
+        w.cavity.push_back(nf);
+    }
+    vertexFace_.edit(p) = w.cavity.back();
+
+    for (std::size_t k = first; k < w.cavity.size(); k++)
+    {
+        int nf = w.cavity[k];
+        int next = w.startAt[faces_[nf].v[2]];
+        faces_.edit(nf).adj[1] = next;
+        faces_.edit(next).adj[2] = nf;
+    }
+
+    for (std::size_t k = first; k < w.cavity.size(); k++)
+    {
+        int nf = w.cavity[k];
+        addTriangle(nf);
+        for (int i = 0; i < 3; i++)
+            addEdge(nf, i, changes);
+    }
+
+    lastFace_ = w.cavity.back();
+}
+
+int Triangulation::twin(int f, int i) const
+{
+    const Face& t = faces_[f];
+    const Face& g = faces_[t.adj[i]];
+    int u = t.v[(i + 1) % 3], w = t.v[(i + 2) % 3];
+    for (int j = 0; j < 3; j++)
+    {
+        if (g.v[j] != u && g.v[j] != w)
+            return 3 * t.adj[i] + j;
+    }
+    return NONE;
+}
+
+bool Triangulation::insertBatch(std::vector<Site> sites, VoronoiChangeSet *changes, const std::atomic<bool> *cancel)
+{
+    std::vector<int> order = hilbertOrder(sites, minX_, minY_, maxX_, maxY_);
+
+    // Un gros lot remplace la plupart des arêtes : l'index est rechargé
+    // d'un coup à la fin plutôt que tenu à jour à chaque insertion
+    indexing_ = sites.size() * 4 < (std::size_t)siteCount();
+    bool done = true;
+    for (std::size_t k = 0; k < order.size(); k++)
+    {
+        if (cancel && k % 1024 == 0 && cancel->load(std::memory_order_relaxed))
+        {
+            done = false;
+            break;
+        }
+        insert(sites[order[k]], changes);
+    }
+    if (!indexing_)
+        rebuildIndex();
+    return done;
+}
+
+void Triangulation::addEdge(int f, int i, VoronoiChangeSet *changes)
+{
+    const Face& t = faces_[f];
+    int u = t.v[(i + 1) % 3], w = t.v[(i + 2) % 3];
+    int g = t.adj[i];
+    if (g == NONE || (isSuper(u) && isSuper(w)) || edgeSlot_[3 * f + i] != NONE)
+        return;
+
+    Segment s{toCoords(centers_[f]), toCoords(centers_[g])};
+    int slot = (int)segments_.size();
+    edgeSlot_.edit(3 * f + i) = slot;
+    edgeSlot_.edit(twin(f, i)) = slot;
+    segments_.push_back(s);
+    segmentEdge_.push_back(3 * f + i);
+    if (indexing_)
+        segmentIndex_.insert(3 * f + i, boxOf(s));
+    if (changes)
+        changes->added.push_back(s);
+}
+
+void Triangulation::removeEdge(int f, int i, VoronoiChangeSet *changes)
+{
+    int slot = edgeSlot_[3 * f + i];
+    if (slot == NONE)
+        return;
+
+    edgeSlot_.edit(3 * f + i) = NONE;
+    edgeSlot_.edit(twin(f, i)) = NONE;
+    if (changes)
+        changes->removed.push_back(segments_[slot]);
+    if (indexing_)
+        segmentIndex_.remove(segmentEdge_[slot]);
+
+    int last = (int)segments_.size() - 1;
+    if (slot != last)
+    {
+        int e = segmentEdge_[last];
+        Segment moved = segments_[last];
+        segments_.edit(slot) = moved;
+        segmentEdge_.edit(slot) = e;
+        edgeSlot_.edit(e) = slot;
+        edgeSlot_.edit(twin(e / 3, e % 3)) = slot;
+    }
+    segments_.pop_back();
+    segmentEdge_.pop_back();
+}
+
+void Triangulation::addTriangle(int f)
+{
+    const Face& t = faces_[f];
+    if (isSuper(t.v[0]) || isSuper(t.v[1]) || isSuper(t.v[2]))
+        return;
+
+    const Site& a = sites_[t.v[0]];
+    const Site& b = sites_[t.v[1]];
+    const Site& d = sites_[t.v[2]];
+    const Site& c = centers_[f];
+    Coords p1 = toCoords(a), p2 = toCoords(b), p3 = toCoords(d);
+    float rsqr = (float)((a.x - c.x) * (a.x - c.x) + (a.y - c.y) * (a.y - c.y));
+    Triangle tri{p1, p2, p3, {p1, p2}, {p2, p3}, {p3, p1}, toCoords(c), rsqr};
+
+    faceSlot_.edit(f) = (int)triangles_.size();
+    triangles_.push_back(tri);
+    triangleFace_.push_back(f);
+    if (indexing_)
+        triangleIndex_.insert(f, boxOf(a, b, d));
+}
+
+void Triangulation::removeTriangle(int f)
+{
+    int slot = faceSlot_[f];
+    if (slot == NONE)
+        return;
+    faceSlot_.edit(f) = NONE;
+
+    int last = (int)triangles_.size() - 1;
+    if (slot != last)
+    {
+        Triangle moved = triangles_[last];
+        int g = triangleFace_[last];
+        triangles_.edit(slot) = moved;
+        triangleFace_.edit(slot) = g;
+        faceSlot_.edit(g) = slot;
+    }
+    triangles_.pop_back();
+    triangleFace_.pop_back();
+    if (indexing_)
+        triangleIndex_.remove(f);
+}
+
+void Triangulation::segmentsIn(double minX, double minY, double maxX, double maxY, std::vector<int>& out) const
+{
+    segmentIndex_.query(minX, minY, maxX, maxY, [&](int e) { out.push_back(edgeSlot_[e]); });
+}
+
+void Triangulation::trianglesIn(double minX, double minY, double maxX, double maxY, std::vector<int>& out) const
+{
+    triangleIndex_.query(minX, minY, maxX, maxY, [&](int f) { out.push_back(faceSlot_[f]); });
+}
+
+int Triangulation::triangleAt(double x, double y) const
+{
+    int found = NONE;
+    triangleIndex_.query(x, y, x, y, [&](int f) {
+        const Face& t = faces_[f];
+        if (found == NONE
+            && orient(sites_[t.v[0]], sites_[t.v[1]], x, y) >= 0
+            && orient(sites_[t.v[1]], sites_[t.v[2]], x, y) >= 0
+            && orient(sites_[t.v[2]], sites_[t.v[0]], x, y) >= 0)
+            found = faceSlot_[f];
+    });
+    return found;
+}
+
+void Triangulation::cell(int v, std::vector<Site>& polygon) const
+{
+    polygon.clear();
+    int start = vertexFace_[v];
+    if (start == NONE)
+        return;
+
+    int f = start;
+    do
+    {
+        polygon.push_back(centers_[f]);
+        const Face& t = faces_[f];
+        int i = t.v[0] == v ? 0 : (t.v[1] == v ? 1 : 2);
+        f = t.adj[(i + 1) % 3];
+    } while (f != start && f != NONE);
+}
+
+/* Bascule l'arête opposée à v[i] dans f : (a, b, c) + (d, c, b) devient (a, b, d) + (a, d, c) */
+void Triangulation::flip(int f, int i)
+{
+    int g = faces_[f].adj[i];
+    Face& F = faces_.edit(f);
+    Face& G = faces_.edit(g);
+    int a = F.v[i], b = F.v[(i + 1) % 3], c = F.v[(i + 2) % 3];
+    int j = twin(f, i) - 3 * g;
+    int d = G.v[j];
+
+    int nCA = F.adj[(i + 1) % 3], nAB = F.adj[(i + 2) % 3];
+    int nBD = G.adj[(j + 1) % 3], nDC = G.adj[(j + 2) % 3];
+
+    F = Face{{a, b, d}, {nBD, g, nAB}, true};
+    G = Face{{a, d, c}, {nDC, nCA, f}, true};
+    auto relink = [this](int n, int from, int to)
+    {
+        if (n == NONE)
+            return;
+        for (int& k: faces_.edit(n).adj)
+        {
+            if (k == from)
+                k = to;
+        }
+    };
+    relink(nBD, g, f);
+    relink(nCA, f, g);
+
+    vertexFace_.edit(a) = f;
+    vertexFace_.edit(b) = f;
+    vertexFace_.edit(d) = f;
+    vertexFace_.edit(c) = g;
+
+    std::vector<std::pair<int, int>>& pending = scratch_.pending;
+    pending.push_back({f, 0});
+    pending.push_back({f, 2});
+    pending.push_back({g, 0});
+    pending.push_back({g, 1});
+}
+
+bool Triangulation::flipIfIllegal(int f, int i)
+{
+    int g = faces_[f].adj[i];
+    if (g == NONE)
+        return false;
+    const Site& d = sites_[faces_[g].v[twin(f, i) - 3 * g]];
+    if (!conflicts(f, d))
+        return false;
+
+    // Avec des poids, une arête illégale peut border un quadrilatère concave
+    const Face& t = faces_[f];
+    const Site& a = sites_[t.v[i]];
+    if (orient(a, sites_[t.v[(i + 1) % 3]], d.x, d.y) <= 0 || orient(a, d, sites_[t.v[(i + 2) % 3]].x, sites_[t.v[(i + 2) % 3]].y) <= 0)
+    {
+        stuck_ = true;
+        return false;
+    }
+    flip(f, i);
+    return true;
+}
+
+/*
+   Une face retournée a un sommet passé de l'autre côté de son plus grand
+   côté : on bascule ce côté si les deux faces obtenues sont bien orientées.
+*/
+bool Triangulation::untangle()
+{
+    for (int pass = 0; pass < 8; pass++)
+    {
+        bool tangled = false;
+        for (int f = 0; f < (int)faces_.size(); f++)
+        {
+            const Face& t = faces_[f];
+            if (!t.alive || orient(sites_[t.v[0]], sites_[t.v[1]], sites_[t.v[2]].x, sites_[t.v[2]].y) > 0)
+                continue;
+            tangled = true;
+
+            int i = 0;
+            double longest = -1;
+            for (int k = 0; k < 3; k++)
+            {
+                const Site& u = sites_[t.v[(k + 1) % 3]];
+                const Site& w = sites_[t.v[(k + 2) % 3]];
+                double l = (u.x - w.x) * (u.x - w.x) + (u.y - w.y) * (u.y - w.y);
+                if (l > longest)
+                {
+                    longest = l;
+                    i = k;
+                }
+            }
+
+            int g = t.adj[i];
+            if (g == NONE)
+                return false;
+            const Site& a = sites_[t.v[i]];
+            const Site& b = sites_[t.v[(i + 1) % 3]];
+            const Site& c = sites_[t.v[(i + 2) % 3]];
+            const Site& d = sites_[faces_[g].v[twin(f, i) - 3 * g]];
+            if (orient(a, b, d.x, d.y) > 0 && orient(a, d, c.x, c.y) > 0)
+                flip(f, i);
+        }
+        if (!tangled)
+            return true;
+    }
+    return false;
+}
+
+bool Triangulation::moveSites(const std::vector<Site>& positions)
+{
+    version_++;
+    for (std::size_t k = 0; k < positions.size() && k + 3 < sites_.size(); k++)
+    {
+        Site& s = sites_.edit(k + 3);
+        s.x = positions[k].x;
+        s.y = positions[k].y;
+    }
+
+    std::vector<std::pair<int, int>>& pending = scratch_.pending;
+    pending.clear();
+    stuck_ = false;
+    bool kinetic = untangle();
+    if (kinetic)
+    {
+        for (int f = 0; f < (int)faces_.size(); f++)
+        {
+            if (faces_[f].alive)
+            {
+                for (int i = 0; i < 3; i++)
+                    pending.push_back({f, i});
+            }
+        }
+
+        // Borne contre les cycles de bascules dus aux arrondis
+        std::size_t budget = 16 * faces_.size() + 64;
+        while (!pending.empty() && budget > 0)
+        {
+            std::pair<int, int> e = pending.back();
+            pending.pop_back();
+            if (flipIfIllegal(e.first, e.second))
+                budget--;
+        }
+        kinetic = pending.empty() && !stuck_;
+
+        // Un site caché qui ressort demande une vraie insertion
+        for (int v = 3; kinetic && v < (int)sites_.size(); v++)
+        {
+            if (vertexFace_[v] != NONE)
+                continue;
+            int duplicate = NONE;
+            int f = locateFree(sites_[v], &duplicate);
+            kinetic = duplicate != NONE || (f != NONE && !conflicts(f, sites_[v]));
+        }
+    }
+
+    if (kinetic)
+    {
+        rebuildDual();
+        return true;
+    }
+
+    // Reconstruction dans l'ordre de Hilbert, chaque site gardant son sommet :
+    // de deux sites confondus seul le plus lourd est visible, et un site
+    // hors du super triangle reste caché
+    std::vector<Site> moved;
+    for (std::size_t v = 3; v < sites_.size(); v++)
+        moved.push_back(sites_[v]);
+    reset(minX_, minY_, maxX_, maxY_);
+    for (const Site& s: moved)
+        sites_.push_back(s);
+    vertexFace_.resize(sites_.size(), NONE);
+    indexing_ = false;
+    for (int k: hilbertOrder(moved, minX_, minY_, maxX_, maxY_))
+    {
+        int duplicate = NONE;
+        int f = locateFree(moved[k], &duplicate);
+        if (f != NONE)
+            insertVertex(k + 3, f, nullptr);
+    }
+    rebuildIndex();
+    return false;
+}
+
+void Triangulation::rebuildIndex()
+{
+    indexing_ = true;
+    segmentIndex_.reset(minX_, minY_, maxX_, maxY_, (int)segments_.size(), (int)edgeSlot_.size());
+    for (std::size_t k = 0; k < segments_.size(); k++)
+        segmentIndex_.insert(segmentEdge_[k], boxOf(segments_[k]));
+    triangleIndex_.reset(minX_, minY_, maxX_, maxY_, (int)triangles_.size(), (int)faces_.size());
+    for (std::size_t k = 0; k < triangleFace_.size(); k++)
+    {
+        int f = triangleFace_[k];
+        const Face& t = faces_[f];
+        triangleIndex_.insert(f, boxOf(sites_[t.v[0]], sites_[t.v[1]], sites_[t.v[2]]));
+    }
+}
+
+void Triangulation::rebuildDual()
+{
+    segments_.clear();
+    segmentEdge_.clear();
+    edgeSlot_.assign(edgeSlot_.size(), NONE);
+    triangles_.clear();
+    triangleFace_.clear();
+    faceSlot_.assign(faceSlot_.size(), NONE);
+    indexing_ = false;
+
+    for (int f = 0; f < (int)faces_.size(); f++)
+    {
+        const Face& t = faces_[f];
+        if (t.alive)
+            centers_.edit(f) = powerCenter(sites_[t.v[0]], sites_[t.v[1]], sites_[t.v[2]]);
+    }
+    for (int f = 0; f < (int)faces_.size(); f++)
+    {
+        if (!faces_[f].alive)
+            continue;
+        addTriangle(f);
+        for (int i = 0; i < 3; i++)
+            addEdge(f, i, nullptr);
+    }
+    rebuildIndex();
+}
@@ -0,0 +1,185 @@
+#ifndef TRIANGULATION_H
+#define TRIANGULATION_H
+#include "geometry.h"
+#include "shared_array.h"
+#include "spatial_index.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/* Site pondéré : avec w != 0 le diagramme est un diagramme de puissance */
+struct Site
+{
+    double x, y;
+    double w = 0;
+};
+
+/* Centre radical de trois sites, centre du cercle circonscrit sans poids */
+Site powerCenter(const Site& a, const Site& b, const Site& c);
+
+/*
+   Arêtes de Voronoi retirées puis ajoutées par une insertion.
+   Une arête modifiée apparaît dans les deux listes.
+*/
+struct VoronoiChangeSet
+{
+    std::vector<Segment> added;
+    std::vector<Segment> removed;
+
+    void clear()
+    {
+        added.clear();
+        removed.clear();
+    }
+};
+
+/*
+   Triangulation de Delaunay incrémentale (Bowyer-Watson avec adjacence)
+   et diagramme de Voronoi dual maintenu au fil des insertions.
+   Avec des sites pondérés, c'est la triangulation régulière et son
+   diagramme de puissance. Les sommets 0, 1 et 2 forment le super triangle.
+   Tout l'état est en tableaux par blocs partagés : une copie coûte la
+   taille des tables de blocs, et ne recopie ensuite que les blocs modifiés.
+*/
+class Triangulation
+{
+public:
+    static constexpr int NONE = -1;
+
+    struct Face
+    {
+        int v[3];   // sommets dans le sens trigonométrique
+        int adj[3]; // adj[i] : face voisine opposée au sommet v[i]
+        bool alive;
+    };
+
+    void reset(double minX, double minY, double maxX, double maxY);
+
+    /*
+       Insère un site et met à jour uniquement les faces de la cavité.
+       Retourne l'indice du nouveau sommet, ou NONE si le point est hors
+       du super triangle. Un doublon d'un sommet au moins aussi lourd
+       n'est pas ajouté et retourne ce sommet ; plus lourd, il devient un
+       nouveau sommet et l'ancien est caché. Un site dominé par le poids
+       de ses voisins est gardé mais caché (voir isHidden).
+    */
+    int insert(const Site& s, VoronoiChangeSet *changes = nullptr);
+    int insert(double x, double y, VoronoiChangeSet *changes = nullptr)
+    {
+        return insert(Site{x, y}, changes);
+    }
+
+    /*
+       Insère un lot de sites dans l'ordre de la courbe de Hilbert, pour des
+       marches courtes. S'arrête et retourne false dès que *cancel passe à true.
+    */
+    bool insertBatch(std::vector<Site> sites, VoronoiChangeSet *changes = nullptr,
+        const std::atomic<bool> *cancel = nullptr);
+
+    /* Test de puissance : p est-il en conflit avec la face f ? */
+    bool conflicts(int f, const Site& p) const;
+
+    /* Marche orientée depuis la face hint, retourne la face contenant (x, y) */
+    int locate(double x, double y, int hint = NONE) const;
+
+    /* Incrémenté à chaque modification, pour invalider les caches */
+    unsigned version() const { return version_; }
+
+    bool isSuper(int v) const { return v < 3; }
+    bool isHidden(int v) const { return vertexFace_[v] == NONE; }
+    int vertexCount() const { return (int)sites_.size(); }
+    int siteCount() const { return sites_.empty() ? 0 : (int)sites_.size() - 3; }
+    const Site& site(int v) const { return sites_[v]; }
+
+    int faceCount() const { return (int)faces_.size(); }
+    const Face& face(int f) const { return faces_[f]; }
+    const Site& center(int f) const { return centers_[f]; }
+    int incidentFace(int v) const { return vertexFace_[v]; }
+
+    /* Cellule de Voronoi de v : centres des faces incidentes, sens trigonométrique */
+    void cell(int v, std::vector<Site>& polygon) const;
+
+    /*
+       Déplace les sites (positions[k] pour le sommet k + 3, les poids sont
+       conservés) puis rétablit la propriété de Delaunay par bascules
+       d'arêtes. Si la réparation échoue, la triangulation est reconstruite
+       et la fonction retourne false. Dans les deux cas le sommet k + 3 reste
+       le site k ; de deux sites confondus après déplacement, le plus léger
+       est gardé mais caché (voir isHidden).
+    */
+    bool moveSites(const std::vector<Site>& positions);
+
+    const SharedArray<Segment>& segments() const { return segments_; }
+    const SharedArray<Triangle>& triangles() const { return triangles_; }
+
+    /*
+       Indices dans segments() et triangles() des éléments dont la boîte
+       englobante touche le rectangle, par la grille tenue à jour à chaque
+       ajout et retrait. Ajoutés à la fin de out.
+    */
+    void segmentsIn(double minX, double minY, double maxX, double maxY, std::vector<int>& out) const;
+    void trianglesIn(double minX, double minY, double maxX, double maxY, std::vector<int>& out) const;
+
+    /* Indice dans triangles() du triangle qui contient (x, y), ou NONE */
+    int triangleAt(double x, double y) const;
+
+private:
+    struct BoundaryEdge
+    {
+        int a, b, outside;
+    };
+
+    int locateFree(const Site& s, int *duplicate) const;
+    void insertVertex(int p, int f, VoronoiChangeSet *changes);
+    void flip(int f, int i);
+    bool flipIfIllegal(int f, int i);
+    bool untangle();
+    void rebuildDual();
+    void rebuildIndex();
+    int allocFace();
+    int twin(int f, int i) const;
+    void addEdge(int f, int i, VoronoiChangeSet *changes);
+    void removeEdge(int f, int i, VoronoiChangeSet *changes);
+    void addTriangle(int f);
+    void removeTriangle(int f);
+
+    unsigned version_ = 0;
+    double minX_ = 0, minY_ = 0, maxX_ = 0, maxY_ = 0;
+    SharedArray<Site> sites_;
+    SharedArray<int> vertexFace_;
+    SharedArray<Face> faces_;
+    SharedArray<Site> centers_;
+    SharedArray<int> freeFaces_;
+    int lastFace_ = NONE;
+
+    // Miroirs denses pour l'affichage, retrait par échange avec le dernier
+    SharedArray<Segment> segments_;
+    SharedArray<int> segmentEdge_; // 3 * face + côté propriétaire de chaque segment
+    SharedArray<int> edgeSlot_;    // segment de chaque côté de face, ou NONE
+    SharedArray<Triangle> triangles_;
+    SharedArray<int> triangleFace_;
+    SharedArray<int> faceSlot_;
+    SpatialIndex segmentIndex_;  // boîtes de segments_, par côté propriétaire 3 * face + i
+    SpatialIndex triangleIndex_; // boîtes de triangles_, par face
+    bool indexing_ = true;        // faux pendant un gros insertBatch
+
+    // Tampons réutilisés d'une insertion à l'autre, jamais copiés :
+    // une copie repart de tampons vides, redimensionnés à l'usage
+    struct Scratch
+    {
+        std::vector<unsigned> mark;
+        unsigned epoch = 0;
+        std::vector<int> cavity;
+        std::vector<BoundaryEdge> boundary;
+        std::vector<int> startAt;
+        std::vector<std::pair<int, int>> pending;
+
+        Scratch() = default;
+        Scratch(const Scratch&) {}
+        Scratch& operator=(const Scratch&) { return *this; }
+    };
+    Scratch scratch_;
+    bool stuck_ = false;
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef VORONOI_CORE_H
+#define VORONOI_CORE_H
+
+/*
+   Cœur de calcul, sans SDL : triangulation de Delaunay incrémentale et
+   diagramme de Voronoi (ou de puissance) dual, index spatial, relaxation
+   de Lloyd, recherche du plus proche site, interpolation par voisins
+   naturels et calcul sur un thread dédié. Lié par la bibliothèque
+   voronoi_core, utilisable sans fenêtre.
+*/
+#include "geometry.h"
+#include "triangulation.h"
+#include "lloyd.h"
+#include "locator.h"
+#include "interpolation.h"
+#include "diagram_worker.h"
+#include "worker_pool.h"
+
+#endif
@@ -0,0 +1,67 @@
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(unsigned threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned w = 1; w < threads; w++)
+        workers_.emplace_back(&WorkerPool::work, this, w);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : workers_)
+        t.join();
+}
+
+void WorkerPool::run(unsigned threads, const std::function<void(unsigned)>& body)
+{
+    threads = std::clamp(threads, 1u, size());
+    if (threads == 1)
+    {
+        body(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        body_ = &body;
+        active_ = threads;
+        pending_ = threads - 1;
+        generation_++;
+    }
+    wake_.notify_all();
+    body(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+    body_ = nullptr;
+}
+
+void WorkerPool::work(unsigned worker)
+{
+    unsigned seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+        if (stopping_)
+            return;
+        seen = generation_;
+        // Un travail sur moins de threads laisse les derniers au repos
+        if (worker >= active_)
+            continue;
+
+        const std::function<void(unsigned)> *body = body_;
+        lock.unlock();
+        (*body)(worker);
+        lock.lock();
+        if (--pending_ == 0)
+            done_.notify_one();
+    }
+}
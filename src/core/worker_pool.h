@@ -0,0 +1,59 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+   Threads gardés d'un appel à l'autre, pour les boucles parallèles lancées
+   à chaque image : parallelFor crée et rejoint ses threads à chaque appel.
+   Un seul thread à la fois appelle run ; il travaille avec le réservoir.
+*/
+class WorkerPool
+{
+public:
+    /* threads compte le thread appelant, 0 : un par cœur */
+    explicit WorkerPool(unsigned threads = 0);
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    ~WorkerPool();
+
+    unsigned size() const { return (unsigned)workers_.size() + 1; }
+
+    /*
+       Appelle body(worker) pour worker dans [0, threads), le 0 sur le thread
+       appelant, et attend qu'ils aient tous fini. threads est borné par size().
+    */
+    void run(unsigned threads, const std::function<void(unsigned)>& body);
+
+private:
+    void work(unsigned worker);
+
+    std::mutex mutex_;
+    std::condition_variable wake_, done_;
+    const std::function<void(unsigned)> *body_ = nullptr;
+    unsigned active_ = 0;  // workers du travail en cours, appelant compris
+    unsigned pending_ = 0; // workers du réservoir pas encore terminés
+    unsigned generation_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+/* parallelFor sur les threads du réservoir : mêmes tranches, même body */
+template <typename Body>
+void parallelFor(WorkerPool& pool, int count, Body body, unsigned threads = 0)
+{
+    if (threads == 0)
+        threads = pool.size();
+    threads = std::min({threads, pool.size(), (unsigned)std::max(count, 1)});
+    int chunk = (count + (int)threads - 1) / (int)threads;
+    pool.run(threads, [&](unsigned worker) {
+        int begin = std::min(count, (int)worker * chunk);
+        body(begin, std::min(count, begin + chunk), worker);
+    });
+}
+
+#endif
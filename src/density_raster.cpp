@@ -0,0 +1,74 @@
+#include "density_raster.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Au-delà, un pixel est opaque
+    const int SATURATION = 16;
+}
+
+DensityRaster::~DensityRaster()
+{
+    release();
+}
+
+void DensityRaster::release()
+{
+    if (texture_)
+        SDL_DestroyTexture(texture_);
+    texture_ = nullptr;
+    textureWidth_ = textureHeight_ = 0;
+}
+
+void DensityRaster::reset(int width, int height)
+{
+    width_ = std::max(width, 0);
+    height_ = std::max(height, 0);
+    counts_.assign((std::size_t)width_ * height_, 0);
+    empty_ = true;
+}
+
+void DensityRaster::submit(SDL_Renderer *renderer, SDL_Color color)
+{
+    if (empty_)
+        return;
+
+    if (!texture_ || textureWidth_ != width_ || textureHeight_ != height_)
+    {
+        release();
+        texture_ = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width_, height_);
+        if (texture_ == NULL)
+        {
+            SDL_Log("Unable to create density texture! SDL Error: %s\n", SDL_GetError());
+            return;
+        }
+        SDL_SetTextureBlendMode(texture_, SDL_BLENDMODE_BLEND);
+        textureWidth_ = width_;
+        textureHeight_ = height_;
+    }
+
+    // Opacité 1 - (1 - a)^n : n primitives d'opacité a superposées
+    Uint32 lut[SATURATION + 1];
+    const Uint32 rgb = ((Uint32)color.r << 16) | ((Uint32)color.g << 8) | color.b;
+    for (int n = 0; n <= SATURATION; n++)
+    {
+        double alpha = 1 - std::pow(0.75, n);
+        lut[n] = ((Uint32)std::lround(alpha * color.a) << 24) | rgb;
+    }
+    lut[SATURATION] = ((Uint32)color.a << 24) | rgb;
+
+    void *pixels;
+    int pitch;
+    if (SDL_LockTexture(texture_, NULL, &pixels, &pitch) != 0)
+        return;
+    for (int y = 0; y < height_; y++)
+    {
+        Uint32 *row = (Uint32 *)((Uint8 *)pixels + (std::size_t)y * pitch);
+        const std::uint16_t *counts = &counts_[(std::size_t)y * width_];
+        for (int x = 0; x < width_; x++)
+            row[x] = lut[std::min<int>(counts[x], SATURATION)];
+    }
+    SDL_UnlockTexture(texture_);
+    SDL_RenderCopy(renderer, texture_, NULL, NULL);
+}
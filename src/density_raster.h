@@ -0,0 +1,50 @@
+#ifndef DENSITY_RASTER_H
+#define DENSITY_RASTER_H
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <vector>
+
+/*
+   Niveau de détail pour les primitives plus petites qu'un pixel : au lieu
+   d'une primitive chacune, elles incrémentent le compteur du pixel qui
+   les contient. Le raster est ensuite envoyé en une seule texture, dont
+   l'opacité croît avec la densité. Le coût d'affichage est borné par la
+   taille de la sortie, pas par celle du maillage.
+*/
+class DensityRaster
+{
+public:
+    DensityRaster() = default;
+    DensityRaster(const DensityRaster&) = delete;
+    DensityRaster& operator=(const DensityRaster&) = delete;
+    ~DensityRaster();
+
+    /* Vide les compteurs, redimensionne si la sortie a changé */
+    void reset(int width, int height);
+    bool empty() const { return empty_; }
+
+    void add(float x, float y)
+    {
+        if (x < 0 || y < 0 || x >= width_ || y >= height_)
+            return;
+        std::uint16_t& count = counts_[(std::size_t)y * width_ + (std::size_t)x];
+        if (count < UINT16_MAX)
+            count++;
+        empty_ = false;
+    }
+
+    /* Dessine les pixels non vides dans la couleur donnée, en un SDL_RenderCopy */
+    void submit(SDL_Renderer *renderer, SDL_Color color);
+
+    /* À appeler avant de détruire le renderer, qui libère ses textures */
+    void release();
+
+private:
+    SDL_Texture *texture_ = nullptr;
+    int width_ = 0, height_ = 0;
+    int textureWidth_ = 0, textureHeight_ = 0;
+    std::vector<std::uint16_t> counts_;
+    bool empty_ = true;
+};
+
+#endif
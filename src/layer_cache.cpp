@@ -0,0 +1,94 @@
+#include "layer_cache.h"
+#include <cmath>
+
+LayerCache::~LayerCache()
+{
+    release();
+}
+
+void LayerCache::release()
+{
+    if (texture_)
+        SDL_DestroyTexture(texture_);
+    texture_ = nullptr;
+    valid_ = false;
+}
+
+SDL_Rect LayerCache::destination(const Camera &camera) const
+{
+    double scale = camera.zoom / camera_.zoom;
+    return SDL_Rect{
+        (int)std::lround((camera_.x - camera.x) * camera.zoom),
+        (int)std::lround((camera_.y - camera.y) * camera.zoom),
+        (int)std::lround(width_ * scale),
+        (int)std::lround(height_ * scale)};
+}
+
+bool LayerCache::begin(SDL_Renderer *renderer, int width, int height, int margin, unsigned version, const Camera &camera,
+    bool stretch)
+{
+    direct_ = !SDL_RenderTargetSupported(renderer);
+    if (direct_)
+    {
+        camera_ = camera;
+        drawWidth_ = width;
+        drawHeight_ = height;
+        return true;
+    }
+
+    // Un déplacement qui garde la sortie couverte se rattrape au moment de composer
+    int w = width + 2 * margin, h = height + 2 * margin;
+    if (valid_ && version == version_ && w == width_ && h == height_ && margin == margin_
+        && (camera.zoom == camera_.zoom || stretch))
+    {
+        SDL_Rect dst = destination(camera);
+        if (dst.x <= 0 && dst.y <= 0 && dst.x + dst.w >= width && dst.y + dst.h >= height)
+            return false;
+    }
+
+    if (!texture_ || w != width_ || h != height_)
+    {
+        if (texture_)
+            SDL_DestroyTexture(texture_);
+        texture_ = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+        if (texture_ == NULL)
+        {
+            SDL_Log("Unable to create layer texture! SDL Error: %s\n", SDL_GetError());
+            direct_ = true;
+            valid_ = false;
+            camera_ = camera;
+            drawWidth_ = width;
+            drawHeight_ = height;
+            return true;
+        }
+        SDL_SetTextureBlendMode(texture_, SDL_BLENDMODE_BLEND);
+        width_ = w;
+        height_ = h;
+    }
+
+    SDL_SetRenderTarget(renderer, texture_);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_TRANSPARENT);
+    SDL_RenderClear(renderer);
+    margin_ = margin;
+    camera_ = camera;
+    camera_.pan(margin, margin);
+    drawWidth_ = w;
+    drawHeight_ = h;
+    version_ = version;
+    valid_ = true;
+    return true;
+}
+
+void LayerCache::end(SDL_Renderer *renderer)
+{
+    if (!direct_)
+        SDL_SetRenderTarget(renderer, NULL);
+}
+
+void LayerCache::compose(SDL_Renderer *renderer, const Camera &camera) const
+{
+    if (direct_ || !valid_)
+        return;
+    SDL_Rect dst = destination(camera);
+    SDL_RenderCopy(renderer, texture_, NULL, &dst);
+}
@@ -0,0 +1,63 @@
+#ifndef LAYER_CACHE_H
+#define LAYER_CACHE_H
+#include "camera.h"
+#include <SDL2/SDL.h>
+
+/*
+   Calque statique mis en cache dans une texture cible, plus grande que la
+   sortie d'une marge de chaque côté. Le contenu n'est redessiné que si la
+   version du modèle, la taille de sortie ou le zoom change, ou si la vue
+   sort de la marge ; sinon il est recopié en un seul SDL_RenderCopy,
+   décalé du déplacement de la caméra. Avec stretch, un changement de zoom
+   est lui aussi rattrapé à la copie, en étirant la texture, tant qu'elle
+   couvre la sortie.
+
+       if (layer.begin(renderer, w, h, margin, version, camera, stretch)) {
+           ... dessin avec layer.camera() sur layer.width() x layer.height() ...
+           layer.end(renderer);
+       }
+       layer.compose(renderer, camera);
+*/
+class LayerCache
+{
+public:
+    LayerCache() = default;
+    LayerCache(const LayerCache&) = delete;
+    LayerCache& operator=(const LayerCache&) = delete;
+    ~LayerCache();
+
+    /*
+       Retourne true si le calque doit être redessiné : la texture est alors
+       la cible courante, vidée en transparent. Sans support des textures
+       cibles, retourne toujours true et le dessin va directement à l'écran,
+       sans marge.
+    */
+    bool begin(SDL_Renderer *renderer, int width, int height, int margin, unsigned version, const Camera &camera,
+        bool stretch = false);
+    void end(SDL_Renderer *renderer);
+    void compose(SDL_Renderer *renderer, const Camera &camera) const;
+    void invalidate() { valid_ = false; }
+
+    /* Vue et taille de la cible du dessin, après un begin qui a retourné true */
+    const Camera& camera() const { return camera_; }
+    int width() const { return drawWidth_; }
+    int height() const { return drawHeight_; }
+
+    /* À appeler avant de détruire le renderer, qui libère ses textures */
+    void release();
+
+private:
+    /* Place de la texture à l'écran pour la vue camera */
+    SDL_Rect destination(const Camera &camera) const;
+
+    SDL_Texture *texture_ = nullptr;
+    int width_ = 0, height_ = 0;
+    int drawWidth_ = 0, drawHeight_ = 0;
+    int margin_ = 0;
+    Camera camera_; // vue du dessin, décalée de la marge
+    unsigned version_ = 0;
+    bool valid_ = false;
+    bool direct_ = false;
+};
+
+#endif
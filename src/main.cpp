@@ -1,339 +1,812 @@
 #include "application_ui.h"
 #include "SDL2_gfxPrimitives.h"
+#include "triangulation.h"
+#include "lloyd.h"
+#include "locator.h"
+#include "render_batch.h"
+#include "layer_cache.h"
+#include "diagram_worker.h"
+#include "camera.h"
+#include "density_raster.h"
+#include "tile_raster.h"
+#include "scene.h"
+#include "raster_worker.h"
+#include "worker_pool.h"
 #include <vector>
 #include <list>
 #include <map>
 #include <queue>
 #include <algorithm>
 #include <iostream>
+#include <cmath>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <cerrno>
+
+const int POINT_RADIUS = 3;
+const int IDLE_WAIT_MS = 1000;
+const double MIN_PAINT_SPACING = 2;
+const double MIN_ZOOM = 1.0 / 64;
+const double MAX_ZOOM = 64;
+const double WHEEL_ZOOM_STEP = 1.2;
+// Durée sans cran de molette après laquelle les calques étirés sont redessinés
+const Uint32 ZOOM_SETTLE_MS = 150;
+const char *HEADLESS_OPTION = "--render";
+const char *CELLS_OPTION = "--cells";
+
+// Niveau de détail : en dessous de LOD_PIXELS à l'écran, une primitive
+// n'est plus qu'un point du raster de densité
+const float LOD_PIXELS = 1.0f;
+// Bord dessiné en plus autour de la fenêtre dans les calques, pour les déplacements
+const int LAYER_MARGIN = 256;
+
+const SDL_Color POINT_COLOR{240, 240, 23, SDL_ALPHA_OPAQUE};
+const SDL_Color SEGMENT_COLOR{240, 240, 20, SDL_ALPHA_OPAQUE};
+const SDL_Color TRIANGLE_COLOR{0, 240, 160, SDL_ALPHA_OPAQUE};
+const SDL_Color BACKGROUND_COLOR{0, 0, 0, SDL_ALPHA_OPAQUE};
+
+// Remplissage des cellules, deux cellules voisines n'ont pas la même couleur
+const SDL_Color CELL_PALETTE[] = {
+    {46, 52, 110, SDL_ALPHA_OPAQUE}, {38, 92, 120, SDL_ALPHA_OPAQUE},
+    {30, 105, 80, SDL_ALPHA_OPAQUE}, {115, 62, 40, SDL_ALPHA_OPAQUE},
+    {88, 42, 104, SDL_ALPHA_OPAQUE}, {112, 96, 34, SDL_ALPHA_OPAQUE},
+    {42, 74, 62, SDL_ALPHA_OPAQUE}, {104, 44, 72, SDL_ALPHA_OPAQUE}};
+const int CELL_COLORS = sizeof(CELL_PALETTE) / sizeof(CELL_PALETTE[0]);
+
+struct Graphics
+{
+    RenderBatch lines;
+    RenderBatch sprites;
+    DensityRaster density;
+    std::vector<int> visible; // résultats des requêtes sur l'index spatial
+    SDL_Texture *pointGlyph = nullptr;
+
+    // Calques statiques, redessinés quand le diagramme change de version,
+    // au zoom ou quand la vue sort de leur marge
+    LayerCache cellsLayer;
+    LayerCache pointsLayer;
+    LayerCache edgesLayer;
+    LayerCache trianglesLayer;
+
+    // Couleur de chaque sommet pour le remplissage des cellules
+    std::vector<std::uint8_t> cellColors;
+    unsigned cellColorsVersion = 0;
+    bool cellColorsValid = false;
+
+    // Rendu logiciel par tuiles sur son thread, à la place des calques
+    RasterWorker raster;
+    std::shared_ptr<const Scene> rasterScene; // dernière scène soumise au rendu logiciel
+};
 
-#define EPSILON 0.0001f
+struct Application
+{
+    int width, height;
+    Camera camera;
+
+    DiagramWorker worker;                         // calculs en arrière-plan
+    std::shared_ptr<const Triangulation> diagram; // dernier diagramme terminé
+    Uint32 diagramReady = 0;                      // évènement poussé par le worker
+    Uint32 frameReady = 0;                        // évènement poussé par le rendu logiciel
+    std::vector<Site> newSites;                   // clics de la passe d'évènements en cours
+    SiteLocator locator;
+    int hovered = Triangulation::NONE;         // site le plus proche du curseur
+    int hoveredTriangle = Triangulation::NONE; // indice dans diagram->triangles()
+
+    // Peinture au glisser : un site tous les paintSpacing pixels
+    bool painting = false;
+    double paintSpacing = 12;
+    double paintX = 0, paintY = 0; // dernier site peint, dans le monde
+
+    bool software = false; // rendu sur le processeur par TileRaster
+    bool cells = false;    // cellules de Voronoi remplies
+    bool dirty = true;     // l'image affichée ne correspond plus au modèle
+    Uint32 zoomedAt = 0;   // dernier cran de molette, en ticks SDL
+};
 
-struct Coords
+/*
+   Une copie du disque pré-rendu par site visible, envoyées en un seul lot.
+   Si les disques couvriraient plus que la fenêtre, chaque site n'est
+   plus qu'un point du raster de densité.
+*/
+void drawPoints(RenderBatch &batch, DensityRaster &density, const Triangulation &diagram,
+    const Camera &camera, const ViewRect &view, int width, int height)
 {
-    int x, y;
+    const float size = 2 * POINT_RADIUS + 1;
+    std::size_t visible = 0;
+    for (int v = 3; v < diagram.vertexCount(); v++)
+        visible += view.contains(diagram.site(v).x, diagram.site(v).y);
+    bool collapse = visible * size * size > (double)width * height;
 
-    bool operator==(const Coords& other)
-    {
-        return x == other.x && y == other.y;
-    }
-    bool operator!=(const Coords& other)
+    for (int v = 3; v < diagram.vertexCount(); v++)
     {
-        return x != other.x || y != other.y;
+        const Site& s = diagram.site(v);
+        if (!view.contains(s.x, s.y))
+            continue;
+        float x = camera.toScreenX(s.x), y = camera.toScreenY(s.y);
+        if (collapse)
+            density.add(x, y);
+        else
+            batch.addSprite(std::round(x) - POINT_RADIUS, std::round(y) - POINT_RADIUS, size, size, POINT_COLOR);
     }
-};
+}
 
-struct Segment
+void drawSegments(RenderBatch &batch, DensityRaster &density, std::vector<int> &visible,
+    const Triangulation &diagram, const Camera &camera, const ViewRect &view)
 {
-    Coords p1, p2;
-
-    bool operator==(const Segment& other)
+    const SharedArray<Segment> &segments = diagram.segments();
+    visible.clear();
+    diagram.segmentsIn(view.minX, view.minY, view.maxX, view.maxY, visible);
+    for (int i : visible)
     {
-        return (p1 == other.p1 && p2 == other.p2)
-        || (p1 == other.p2 && p2 == other.p1);
+        const Segment& s = segments[i];
+        float x1 = camera.toScreenX(s.p1.x), y1 = camera.toScreenY(s.p1.y);
+        float x2 = camera.toScreenX(s.p2.x), y2 = camera.toScreenY(s.p2.y);
+        if (std::fabs(x2 - x1) + std::fabs(y2 - y1) < LOD_PIXELS)
+            density.add((x1 + x2) / 2, (y1 + y2) / 2);
+        else
+            batch.addLine(x1, y1, x2, y2, SEGMENT_COLOR);
     }
-    bool operator!=(const Segment& other)
+}
+
+void drawTriangles(RenderBatch &batch, DensityRaster &density, std::vector<int> &visible,
+    const Triangulation &diagram, const Camera &camera, const ViewRect &view)
+{
+    const SharedArray<Triangle> &triangles = diagram.triangles();
+    visible.clear();
+    diagram.trianglesIn(view.minX, view.minY, view.maxX, view.maxY, visible);
+    for (int i : visible)
     {
-        return (p1 != other.p1 || p2 != other.p2)
-        && (p1 != other.p2 || p2 != other.p1);
+        const Triangle& t = triangles[i];
+        float x1 = camera.toScreenX(t.p1.x), y1 = camera.toScreenY(t.p1.y);
+        float x2 = camera.toScreenX(t.p2.x), y2 = camera.toScreenY(t.p2.y);
+        float x3 = camera.toScreenX(t.p3.x), y3 = camera.toScreenY(t.p3.y);
+        float extent = std::max({x1, x2, x3}) - std::min({x1, x2, x3}) + std::max({y1, y2, y3}) - std::min({y1, y2, y3});
+        if (extent < LOD_PIXELS)
+        {
+            density.add((x1 + x2 + x3) / 3, (y1 + y2 + y3) / 3);
+            continue;
+        }
+        batch.addLine(x1, y1, x2, y2, TRIANGLE_COLOR);
+        batch.addLine(x2, y2, x3, y3, TRIANGLE_COLOR);
+        batch.addLine(x3, y3, x1, y1, TRIANGLE_COLOR);
     }
-};
+}
 
-struct Triangle
+/*
+   Coloriage glouton du graphe de Delaunay : chaque site prend la première
+   couleur de la palette absente de ses voisins déjà coloriés.
+*/
+void coloreCellules(const Triangulation &diagram, std::vector<std::uint8_t> &colors)
 {
-    Coords p1, p2, p3;
-    Segment s1{p1, p2}, s2{p2, p3}, s3{p3, p1};
-    Coords center;
-    float radius;
-    bool complet=false;
-
-    bool operator==(const Triangle& other)
+    colors.assign(diagram.vertexCount(), 0);
+    for (int v = 3; v < diagram.vertexCount(); v++)
     {
-        return p1 == other.p1 && p2 == other.p2 && p3 == other.p3;
+        int start = diagram.incidentFace(v);
+        if (start == Triangulation::NONE)
+            continue;
+
+        unsigned used = 0;
+        int f = start;
+        do
+        {
+            const Triangulation::Face& t = diagram.face(f);
+            int i = t.v[0] == v ? 0 : (t.v[1] == v ? 1 : 2);
+            int u = t.v[(i + 1) % 3];
+            if (u < v && !diagram.isSuper(u))
+                used |= 1u << colors[u];
+            f = t.adj[(i + 1) % 3];
+        } while (f != start && f != Triangulation::NONE);
+
+        int color = 0;
+        while (color < CELL_COLORS && (used & (1u << color)))
+            color++;
+        colors[v] = (std::uint8_t)(color < CELL_COLORS ? color : v % CELL_COLORS);
     }
-};
+}
 
-struct Application
+/* Cellule du sommet v en pixels, false si elle est vide ou hors de la vue */
+bool cellOnScreen(const Triangulation &diagram, int v, const Camera &camera, const ViewRect &view,
+    std::vector<Site> &cell, std::vector<SDL_FPoint> &points)
 {
-    int width, height;
-    Coords focus{100, 100};
+    diagram.cell(v, cell);
+    if (cell.size() < 3)
+        return false;
 
-    std::vector<Coords> points;
-    std::vector<Segment> segments;
-    std::vector<Triangle> triangles;
-};
+    double minX = cell[0].x, maxX = cell[0].x, minY = cell[0].y, maxY = cell[0].y;
+    for (const Site& p : cell)
+    {
+        minX = std::min(minX, p.x);
+        maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y);
+        maxY = std::max(maxY, p.y);
+    }
+    if (!view.overlaps(minX, minY, maxX, maxY))
+        return false;
 
-bool compareCoords(Coords point1, Coords point2)
-{
-    if (point1.x == point2.x)
-        return point1.y < point2.y;
-    return point1.x < point2.x;
+    points.clear();
+    for (const Site& p : cell)
+        points.push_back(SDL_FPoint{(float)camera.toScreenX(p.x), (float)camera.toScreenY(p.y)});
+    return true;
 }
 
-void drawPoints(SDL_Renderer *renderer, const std::vector<Coords> &points)
+/*
+   Cellules de Voronoi remplies, en éventails dans un seul lot. Les cellules
+   du bord, fermées par les centres des faces du super triangle, sont
+   découpées par la zone de découpe du lot.
+*/
+void drawCells(RenderBatch &batch, const std::vector<std::uint8_t> &colors, const Triangulation &diagram,
+    const Camera &camera, const ViewRect &view)
 {
-    for (std::size_t i = 0; i < points.size(); i++)
+    std::vector<Site> cell;
+    std::vector<SDL_FPoint> points;
+    for (int v = 3; v < diagram.vertexCount(); v++)
     {
-        filledCircleRGBA(renderer, points[i].x, points[i].y, 3, 240, 240, 23, SDL_ALPHA_OPAQUE);
+        if (cellOnScreen(diagram, v, camera, view, cell, points))
+            batch.addPolygon(points.data(), (int)points.size(), CELL_PALETTE[colors[v]]);
     }
 }
 
-void drawSegments(SDL_Renderer *renderer, const std::vector<Segment> &segments)
+/*
+   Sites, arêtes de Voronoi (anticrénelées) et triangles de Delaunay dans
+   le framebuffer logiciel, dans l'ordre des calques, par-dessus les
+   cellules remplies si cellColors est donné. Le dessin lui-même se fait
+   dans TileRaster::render, sur les threads d'un WorkerPool.
+*/
+void rasteriseDiagram(TileRaster &tiles, std::vector<int> &visible, const Triangulation &diagram,
+    const Camera &camera, const ViewRect &view, const std::vector<std::uint8_t> *cellColors = nullptr)
 {
-    for (std::size_t i = 0; i < segments.size(); i++)
+    if (cellColors)
+    {
+        std::vector<Site> cell;
+        std::vector<SDL_FPoint> points;
+        for (int v = 3; v < diagram.vertexCount(); v++)
+        {
+            if (cellOnScreen(diagram, v, camera, view, cell, points))
+                tiles.addPolygon(points.data(), (int)points.size(), CELL_PALETTE[(*cellColors)[v]]);
+        }
+    }
+
+    for (int v = 3; v < diagram.vertexCount(); v++)
     {
-        lineRGBA(
-            renderer,
-            segments[i].p1.x, segments[i].p1.y,
-            segments[i].p2.x, segments[i].p2.y,
-            240, 240, 20, SDL_ALPHA_OPAQUE);
+        const Site& s = diagram.site(v);
+        if (view.contains(s.x, s.y))
+            tiles.addDisc(camera.toScreenX(s.x), camera.toScreenY(s.y), POINT_RADIUS, POINT_COLOR);
     }
-}
 
-void drawTriangles(SDL_Renderer *renderer, const std::vector<Triangle> &triangles)
-{
-    for (std::size_t i = 0; i < triangles.size(); i++)
+    const SharedArray<Segment> &segments = diagram.segments();
+    visible.clear();
+    diagram.segmentsIn(view.minX, view.minY, view.maxX, view.maxY, visible);
+    for (int i : visible)
+    {
+        const Segment& s = segments[i];
+        tiles.addLine(camera.toScreenX(s.p1.x), camera.toScreenY(s.p1.y),
+            camera.toScreenX(s.p2.x), camera.toScreenY(s.p2.y), SEGMENT_COLOR, true);
+    }
+
+    const SharedArray<Triangle> &triangles = diagram.triangles();
+    visible.clear();
+    diagram.trianglesIn(view.minX, view.minY, view.maxX, view.maxY, visible);
+    for (int i : visible)
     {
         const Triangle& t = triangles[i];
-        trigonRGBA(
-            renderer,
-            t.p1.x, t.p1.y,
-            t.p2.x, t.p2.y,
-            t.p3.x, t.p3.y,
-            0, 240, 160, SDL_ALPHA_OPAQUE
-        );
+        float x1 = camera.toScreenX(t.p1.x), y1 = camera.toScreenY(t.p1.y);
+        float x2 = camera.toScreenX(t.p2.x), y2 = camera.toScreenY(t.p2.y);
+        float x3 = camera.toScreenX(t.p3.x), y3 = camera.toScreenY(t.p3.y);
+        tiles.addLine(x1, y1, x2, y2, TRIANGLE_COLOR);
+        tiles.addLine(x2, y2, x3, y3, TRIANGLE_COLOR);
+        tiles.addLine(x3, y3, x1, y1, TRIANGLE_COLOR);
     }
 }
 
-void draw(SDL_Renderer *renderer, const Application &app)
+/*
+   Rendu logiciel d'une scène, appelé depuis le thread de RasterWorker : ne
+   lit que la scène et son diagramme figé.
+*/
+void rasteriseScene(TileRaster &tiles, const Scene &scene)
 {
-    /* Remplissez cette fonction pour faire l'affichage du jeu */
-    int width, height;
-    SDL_GetRendererOutputSize(renderer, &width, &height);
+    std::vector<int> visible;
+    std::vector<std::uint8_t> cellColors;
+    if (scene.cells)
+        coloreCellules(*scene.diagram, cellColors);
+    tiles.reset(scene.width, scene.height, BACKGROUND_COLOR);
+    rasteriseDiagram(tiles, visible, *scene.diagram, scene.camera,
+        scene.camera.visible(scene.width, scene.height, POINT_RADIUS + 1), scene.cells ? &cellColors : nullptr);
+}
+
+void drawHovered(SDL_Renderer *renderer, const Scene &scene)
+{
+    const SharedArray<Triangle> &triangles = scene.diagram->triangles();
+    if (scene.hoveredTriangle != Triangulation::NONE && scene.hoveredTriangle < (int)triangles.size())
+    {
+        const Triangle &t = triangles[scene.hoveredTriangle];
+        const Camera &c = scene.camera;
+        trigonRGBA(renderer,
+            (Sint16)std::lround(c.toScreenX(t.p1.x)), (Sint16)std::lround(c.toScreenY(t.p1.y)),
+            (Sint16)std::lround(c.toScreenX(t.p2.x)), (Sint16)std::lround(c.toScreenY(t.p2.y)),
+            (Sint16)std::lround(c.toScreenX(t.p3.x)), (Sint16)std::lround(c.toScreenY(t.p3.y)),
+            255, 255, 255, 96);
+    }
 
-    drawPoints(renderer, app.points);
-    drawSegments(renderer, app.segments);
-    drawTriangles(renderer, app.triangles);
+    if (scene.hovered == Triangulation::NONE || scene.hovered >= scene.diagram->vertexCount())
+        return;
+
+    const Site& s = scene.diagram->site(scene.hovered);
+    circleRGBA(renderer,
+        (Sint16)std::lround(scene.camera.toScreenX(s.x)), (Sint16)std::lround(scene.camera.toScreenY(s.y)),
+        6, 255, 255, 255, SDL_ALPHA_OPAQUE);
 }
 
 /*
-   Détermine si un point se trouve dans un cercle définit par trois points
-   Retourne, par les paramètres, le centre et le rayon
+   Partie du monde que couvre un calque à redessiner, marge comprise ;
+   la découpe des lots est mise à la taille du calque.
 */
-bool CircumCircle(
-    float pX, float pY,
-    float x1, float y1, float x2, float y2, float x3, float y3,
-    float *xc, float *yc, float *rsqr
-)
+ViewRect layerView(Graphics &gfx, const LayerCache &layer)
 {
-    float m1, m2, mx1, mx2, my1, my2;
-    float dx, dy, drsqr;
-    float fabsy1y2 = fabs(y1 - y2);
-    float fabsy2y3 = fabs(y2 - y3);
+    gfx.lines.setClip(-1, -1, layer.width() + 1, layer.height() + 1);
+    gfx.sprites.setClip(-1, -1, layer.width() + 1, layer.height() + 1);
+    return layer.camera().visible(layer.width(), layer.height(), POINT_RADIUS + 1);
+}
 
-    /* Check for coincident points */
-    if (fabsy1y2 < EPSILON && fabsy2y3 < EPSILON)
-        return (false);
+/*
+   Affiche une scène figée, sans lire l'état de l'application : les
+   évènements peuvent en préparer une autre pendant que le thread de rendu
+   logiciel dessine celle-ci.
+*/
+void draw(SDL_Renderer *renderer, Graphics &gfx, const std::shared_ptr<const Scene> &current)
+{
+    /* Remplissez cette fonction pour faire l'affichage du jeu */
+    const Scene &scene = *current;
+    const int width = scene.width, height = scene.height;
+    const Camera &camera = scene.camera;
+    const Triangulation &diagram = *scene.diagram;
+    unsigned version = diagram.version();
 
-    if (fabsy1y2 < EPSILON)
+    if (scene.software)
     {
-        m2 = -(x3 - x2) / (y3 - y2);
-        mx2 = (x2 + x3) / 2.0;
-        my2 = (y2 + y3) / 2.0;
-        *xc = (x2 + x1) / 2.0;
-        *yc = m2 * (*xc - mx2) + my2;
+        // Dernière image terminée, la suivante arrive avec frameReady
+        if (!gfx.rasterScene || !gfx.rasterScene->sameImage(scene))
+        {
+            gfx.raster.submit(current);
+            gfx.rasterScene = current;
+        }
+        if (std::shared_ptr<RasterWorker::Frame> frame = gfx.raster.frame())
+            frame->tiles.submit(renderer);
+        drawHovered(renderer, scene);
+        return;
     }
-    else if (fabsy2y3 < EPSILON)
+
+    if (scene.cells && (!gfx.cellColorsValid || gfx.cellColorsVersion != version))
     {
-        m1 = -(x2 - x1) / (y2 - y1);
-        mx1 = (x1 + x2) / 2.0;
-        my1 = (y1 + y2) / 2.0;
-        *xc = (x3 + x2) / 2.0;
-        *yc = m1 * (*xc - mx1) + my1;
+        coloreCellules(diagram, gfx.cellColors);
+        gfx.cellColorsVersion = version;
+        gfx.cellColorsValid = true;
     }
-    else
+
+    if (scene.cells)
     {
-        m1 = -(x2 - x1) / (y2 - y1);
-        m2 = -(x3 - x2) / (y3 - y2);
-        mx1 = (x1 + x2) / 2.0;
-        mx2 = (x2 + x3) / 2.0;
-        my1 = (y1 + y2) / 2.0;
-        my2 = (y2 + y3) / 2.0;
-        *xc = (m1 * mx1 - m2 * mx2 + my2 - my1) / (m1 - m2);
-        if (fabsy1y2 > fabsy2y3)
+        if (gfx.cellsLayer.begin(renderer, width, height, LAYER_MARGIN, version, camera, scene.zooming))
         {
-            *yc = m1 * (*xc - mx1) + my1;
-        }
-        else
-        {
-            *yc = m2 * (*xc - mx2) + my2;
+            const LayerCache &layer = gfx.cellsLayer;
+            const ViewRect view = layerView(gfx, layer);
+            gfx.lines.clear();
+            drawCells(gfx.lines, gfx.cellColors, diagram, layer.camera(), view);
+            gfx.lines.submit(renderer);
+            gfx.cellsLayer.end(renderer);
         }
+        gfx.cellsLayer.compose(renderer, camera);
     }
 
-    dx = x2 - *xc;
-    dy = y2 - *yc;
-    *rsqr = dx * dx + dy * dy;
-
-    dx = pX - *xc;
-    dy = pY - *yc;
-    drsqr = dx * dx + dy * dy;
+    if (gfx.pointsLayer.begin(renderer, width, height, LAYER_MARGIN, version, camera, scene.zooming))
+    {
+        const LayerCache &layer = gfx.pointsLayer;
+        const ViewRect view = layerView(gfx, layer);
+        gfx.sprites.clear();
+        gfx.density.reset(layer.width(), layer.height());
+        drawPoints(gfx.sprites, gfx.density, diagram, layer.camera(), view, layer.width(), layer.height());
+        gfx.sprites.submit(renderer, gfx.pointGlyph);
+        gfx.density.submit(renderer, POINT_COLOR);
+        gfx.pointsLayer.end(renderer);
+    }
+    gfx.pointsLayer.compose(renderer, camera);
 
-    return ((drsqr - *rsqr) <= EPSILON ? true : false);
-}
+    if (gfx.edgesLayer.begin(renderer, width, height, LAYER_MARGIN, version, camera, scene.zooming))
+    {
+        const LayerCache &layer = gfx.edgesLayer;
+        const ViewRect view = layerView(gfx, layer);
+        gfx.lines.clear();
+        gfx.density.reset(layer.width(), layer.height());
+        drawSegments(gfx.lines, gfx.density, gfx.visible, diagram, layer.camera(), view);
+        gfx.lines.submit(renderer);
+        gfx.density.submit(renderer, SEGMENT_COLOR);
+        gfx.edgesLayer.end(renderer);
+    }
+    gfx.edgesLayer.compose(renderer, camera);
 
-void construitDelaunay(Application &app) {
-    std::sort(app.points.begin(), app.points.end(), compareCoords);
-    app.triangles.clear();
-    app.triangles.push_back({{-1000, -1000}, {500, 3000}, {1500, -1000}});
-
-    for (Coords& p: app.points) {
-        std::vector<Segment> segments;
-        std::vector<Segment> bad_segments;
-        std::vector<Triangle> bad_triangles;
-        
-        float xc, yc, rsqr;
-        for (Triangle& t: app.triangles) {
-            bool inCircle = CircumCircle(p.x, p.y,
-                    t.p1.x, t.p1.y, t.p2.x, t.p2.y, t.p3.x, t.p3.y,
-                    &xc, &yc, &rsqr);
-            t.center = Coords{(int)xc, (int)yc};
-            t.radius = rsqr;
-            if (inCircle) {
-                segments.push_back(t.s1);
-                segments.push_back(t.s2);
-                segments.push_back(t.s3);
-                bad_triangles.push_back(t);
-            }
-        }
+    if (gfx.trianglesLayer.begin(renderer, width, height, LAYER_MARGIN, version, camera, scene.zooming))
+    {
+        const LayerCache &layer = gfx.trianglesLayer;
+        const ViewRect view = layerView(gfx, layer);
+        gfx.lines.clear();
+        gfx.density.reset(layer.width(), layer.height());
+        drawTriangles(gfx.lines, gfx.density, gfx.visible, diagram, layer.camera(), view);
+        gfx.lines.submit(renderer);
+        gfx.density.submit(renderer, TRIANGLE_COLOR);
+        gfx.trianglesLayer.end(renderer);
+    }
+    gfx.trianglesLayer.compose(renderer, camera);
 
-        for (unsigned int i = 0; i < segments.size(); i++) {
-            for (unsigned int j = i + 1; j < segments.size(); j++) {
-                if (segments[i] == segments[j]) {
-                    bad_segments.push_back(segments[i]);
-                }
-            }
-        }
+    // Survol dessiné par-dessus les calques, à chaque image
+    drawHovered(renderer, scene);
+}
 
-        for (Triangle bt: bad_triangles) {
-            auto to_delete = std::remove(app.triangles.begin(), app.triangles.end(), bt);
-            app.triangles.erase(to_delete, app.triangles.end());
-        }
+/* Fige ce que la fenêtre doit afficher maintenant */
+std::shared_ptr<const Scene> figeScene(const Application &app, int width, int height)
+{
+    auto scene = std::make_shared<Scene>();
+    scene->diagram = app.diagram;
+    scene->camera = app.camera;
+    scene->width = width;
+    scene->height = height;
+    scene->hovered = app.hovered;
+    scene->hoveredTriangle = app.hoveredTriangle;
+    scene->software = app.software;
+    scene->cells = app.cells;
+    scene->zooming = app.zoomedAt != 0 && SDL_GetTicks() - app.zoomedAt < ZOOM_SETTLE_MS;
+    return scene;
+}
 
-        for (Segment bs: bad_segments) {
-            auto to_delete = std::remove(segments.begin(), segments.end(), bs);
-            segments.erase(to_delete, segments.end());
-        }
+/*
+   Envoie en un seul lot les sites cliqués depuis la dernière passe
+   d'évènements, au lieu d'une insertion par clic.
+*/
+void appliqueInsertions(Application &app)
+{
+    if (app.newSites.empty())
+        return;
+    app.worker.insert(std::move(app.newSites));
+    app.newSites.clear();
+}
 
-        for (Segment s: segments) {
-            app.triangles.push_back(Triangle {s.p1, s.p2, p});
-        }
-    }
+/*
+   Les constructions partent sur le thread de calcul : l'affichage garde le
+   dernier diagramme terminé jusqu'à l'arrivée de diagramReady.
+*/
+void construitDelaunay(Application &app) {
+    appliqueInsertions(app);
+    app.worker.rebuild(0, 0, app.width, app.height);
 }
 
+/* Le dual de Voronoi est maintenu par la triangulation */
 void construitVoronoi(Application &app)
 {
     construitDelaunay(app);
+}
 
-    std::vector<Triangle> delaunay_tri = app.triangles;
-
-    app.segments.clear();
-    std::vector<Coords> points;
-        std::vector<int> point_counts;
-    for (Coords& p: app.points) {
-        std::vector<Triangle> good_triangles;
-        float xc, yc, rsqr;
-        for (Triangle t: delaunay_tri) {
-            bool inCircle = CircumCircle(p.x, p.y,
-                    t.p1.x, t.p1.y, t.p2.x, t.p2.y, t.p3.x, t.p3.y,
-                    &xc, &yc, &rsqr);
-            t.center = Coords{(int)xc, (int)yc};
-            t.radius = rsqr;
-            if (p == t.p1 || p == t.p2 || p == t.p3) {
-                good_triangles.push_back(t);
-            }
-        }
+/*
+   Ajoute un site sans reconstruire : seules les cellules des voisins de
+   Delaunay du nouveau site sont recalculées. L'insertion est différée
+   jusqu'à la fin de la passe d'évènements.
+*/
+void insereSite(Application &app, double x, double y)
+{
+    app.newSites.push_back(Site{x, y});
+}
 
-        for (int i = 0; i < (int)good_triangles.size(); i++) {
-            for (int j = i + 1; j < (int)good_triangles.size(); j++) {
-                bool hasSegmentInCommon = good_triangles[i].s1 == good_triangles[j].s1 ||
-                    good_triangles[i].s1 == good_triangles[j].s2 ||
-                    good_triangles[i].s1 == good_triangles[j].s3 ||
-                    good_triangles[i].s2 == good_triangles[j].s1 ||
-                    good_triangles[i].s2 == good_triangles[j].s2 ||
-                    good_triangles[i].s2 == good_triangles[j].s3 ||
-                    good_triangles[i].s3 == good_triangles[j].s1 ||
-                    good_triangles[i].s3 == good_triangles[j].s2 ||
-                    good_triangles[i].s3 == good_triangles[j].s3;
-                if (hasSegmentInCommon) {
-                    app.segments.push_back(Segment {good_triangles[i].center, good_triangles[j].center});
-                }
-            }
-        }
-    }
+/* Seuls les sites dans le cadre de la fenêtre sont posés */
+bool insideWindow(const Application &app, double x, double y)
+{
+    return x >= 0 && y >= 0 && x < app.width && y < app.height;
+}
 
-    std::vector<Triangle> bad_triangles;
-
-    for (Triangle t: app.triangles) {
-        bool hasCommonPointsWithSuperTriangle = t.p1 == Coords{-1000, -1000} ||
-                t.p1 == Coords{500, 3000} ||
-                t.p1 == Coords{1500, -1000} ||
-                t.p2 == Coords{-1000, -1000} ||
-                t.p2 == Coords{500, 3000} ||
-                t.p2 == Coords{1500, -1000} ||
-                t.p3 == Coords{-1000, -1000} ||
-                t.p3 == Coords{500, 3000} ||
-                t.p3 == Coords{1500, -1000};
-        if (hasCommonPointsWithSuperTriangle) {
-            bad_triangles.push_back(t);
-        }
-    }
+/* Début d'un trait : le premier site est posé sous le curseur */
+void commencePeinture(Application &app, double x, double y)
+{
+    app.painting = true;
+    app.paintX = x;
+    app.paintY = y;
+    if (insideWindow(app, x, y))
+        insereSite(app, x, y);
+}
 
-    for (Triangle bt: bad_triangles) {
-        auto to_delete = std::remove(app.triangles.begin(), app.triangles.end(), bt);
-        app.triangles.erase(to_delete, app.triangles.end());
+/*
+   Pose des sites régulièrement espacés le long du déplacement de la
+   souris depuis le dernier site peint, l'espacement étant mesuré à
+   l'écran. Les sites d'une même passe d'évènements partent ensemble
+   dans appliqueInsertions.
+*/
+void peintSites(Application &app, double x, double y)
+{
+    double dx = x - app.paintX, dy = y - app.paintY;
+    double length = std::sqrt(dx * dx + dy * dy);
+    double spacing = app.paintSpacing / app.camera.zoom;
+    int steps = (int)(length / spacing);
+    for (int i = 1; i <= steps; i++)
+    {
+        double px = app.paintX + dx * i * spacing / length;
+        double py = app.paintY + dy * i * spacing / length;
+        if (insideWindow(app, px, py))
+            insereSite(app, px, py);
+    }
+    if (steps > 0)
+    {
+        app.paintX += dx * steps * spacing / length;
+        app.paintY += dy * steps * spacing / length;
     }
 }
 
-bool handleEvent(Application &app)
+/*
+   Relaxation de Lloyd sur le diagramme courant, les sites convergent vers
+   les centroïdes de leurs cellules dans la fenêtre.
+*/
+void relaxeSites(Application &app)
+{
+    appliqueInsertions(app);
+
+    LloydSettings settings;
+    settings.minX = 0;
+    settings.minY = 0;
+    settings.maxX = app.width;
+    settings.maxY = app.height;
+    app.worker.relax(std::move(settings));
+}
+
+/*
+   Traite les évènements en attente. Si idle, dort d'abord dans
+   SDL_WaitEventTimeout jusqu'au prochain évènement.
+*/
+bool handleEvent(Application &app, bool idle)
 {
     /* Remplissez cette fonction pour gérer les inputs utilisateurs */
     SDL_Event e;
-    while (SDL_PollEvent(&e))
+    bool pending = idle ? SDL_WaitEventTimeout(&e, IDLE_WAIT_MS) : SDL_PollEvent(&e);
+    for (; pending; pending = SDL_PollEvent(&e))
     {
         if (e.type == SDL_QUIT)
             return false;
-        else if (e.type == SDL_WINDOWEVENT_RESIZED)
+        else if (e.type == SDL_WINDOWEVENT)
+        {
+            if (e.window.event == SDL_WINDOWEVENT_RESIZED)
+            {
+                app.width = e.window.data1;
+                app.height = e.window.data2;
+                construitVoronoi(app);
+            }
+            app.dirty = true;
+        }
+        else if (e.type == app.frameReady)
+            app.dirty = true;
+        else if (e.type == app.diagramReady)
         {
-            app.width = e.window.data1;
-            app.height = e.window.data1;
+            // Les indices de triangles changent d'un instantané à l'autre
+            app.diagram = app.worker.snapshot();
+            app.hoveredTriangle = Triangulation::NONE;
+            app.dirty = true;
+        }
+        else if (e.type == SDL_MOUSEMOTION)
+        {
+            double x = app.camera.toWorldX(e.motion.x), y = app.camera.toWorldY(e.motion.y);
+            if (e.motion.state & SDL_BUTTON_MMASK)
+            {
+                app.camera.pan(e.motion.xrel, e.motion.yrel);
+                app.dirty = true;
+            }
+            else if (app.painting)
+                peintSites(app, x, y);
+            int hovered = app.locator.nearestSite(*app.diagram, x, y);
+            int hoveredTriangle = app.diagram->triangleAt(x, y);
+            app.dirty |= hovered != app.hovered || hoveredTriangle != app.hoveredTriangle;
+            app.hovered = hovered;
+            app.hoveredTriangle = hoveredTriangle;
         }
         else if (e.type == SDL_MOUSEWHEEL)
         {
+            // Zoom centré sur le curseur
+            int mouseX, mouseY;
+            SDL_GetMouseState(&mouseX, &mouseY);
+            double zoom = app.camera.zoom * std::pow(WHEEL_ZOOM_STEP, e.wheel.y);
+            app.camera.zoomAt(mouseX, mouseY, std::clamp(zoom, MIN_ZOOM, MAX_ZOOM));
+            app.zoomedAt = SDL_GetTicks();
+            app.dirty = true;
+        }
+        else if (e.type == SDL_KEYDOWN)
+        {
+            if (e.key.keysym.sym == SDLK_l)
+                relaxeSites(app);
+            else if (e.key.keysym.sym == SDLK_s)
+            {
+                app.software = !app.software;
+                app.dirty = true;
+            }
+            else if (e.key.keysym.sym == SDLK_c)
+            {
+                app.cells = !app.cells;
+                app.dirty = true;
+            }
+            else if (e.key.keysym.sym == SDLK_PLUS || e.key.keysym.sym == SDLK_EQUALS || e.key.keysym.sym == SDLK_KP_PLUS)
+                app.paintSpacing *= 1.25;
+            else if (e.key.keysym.sym == SDLK_MINUS || e.key.keysym.sym == SDLK_KP_MINUS)
+                app.paintSpacing = std::max(MIN_PAINT_SPACING, app.paintSpacing / 1.25);
+        }
+        else if (e.type == SDL_MOUSEBUTTONDOWN)
+        {
+            if (e.button.button == SDL_BUTTON_LEFT)
+                commencePeinture(app, app.camera.toWorldX(e.button.x), app.camera.toWorldY(e.button.y));
         }
         else if (e.type == SDL_MOUSEBUTTONUP)
         {
             if (e.button.button == SDL_BUTTON_RIGHT)
             {
-                app.focus.x = e.button.x;
-                app.focus.y = e.button.y;
-                app.points.clear();
+                app.newSites.clear();
+                app.painting = false;
+                app.worker.clear(0, 0, app.width, app.height);
+                app.hovered = Triangulation::NONE;
+                app.hoveredTriangle = Triangulation::NONE;
             }
             else if (e.button.button == SDL_BUTTON_LEFT)
             {
-                app.focus.y = 0;
-                app.points.push_back(Coords{e.button.x, e.button.y});
-                construitVoronoi(app);
+                app.painting = false;
             }
         }
     }
+    appliqueInsertions(app);
+    return true;
+}
+
+/* Sites d'un fichier texte, une ligne "x y" ou "x y poids" par site, # pour commenter */
+bool chargeSites(const std::string &path, std::vector<Site> &sites)
+{
+    std::ifstream file(path);
+    if (!file)
+        return false;
+    sites.clear();
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream in(line.substr(0, line.find('#')));
+        Site s;
+        if (in >> s.x >> s.y)
+        {
+            in >> s.w;
+            sites.push_back(s);
+        }
+    }
     return true;
 }
 
-int main()
+/* Extension de path en minuscules, point compris : ".bmp", ".ppm"... */
+std::string imageExtension(const std::string &path)
 {
+    std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : "";
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    return extension;
+}
+
+/*
+   Le framebuffer en BMP par SDL_SaveBMP ou en PPM binaire, selon
+   l'extension (.bmp ou .ppm). En cas d'échec, error reçoit la cause.
+*/
+bool enregistreImage(const TileRaster &tiles, const std::string &path, std::string &error)
+{
+    const int width = tiles.width(), height = tiles.height();
+    const std::string extension = imageExtension(path);
+    if (extension == ".bmp")
+    {
+        SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<std::uint32_t *>(tiles.pixels()),
+            width, height, 32, width * (int)sizeof(std::uint32_t), SDL_PIXELFORMAT_ARGB8888);
+        bool saved = surface && SDL_SaveBMP(surface, path.c_str()) == 0;
+        if (!saved)
+            error = SDL_GetError();
+        SDL_FreeSurface(surface);
+        return saved;
+    }
+    if (extension != ".ppm")
+    {
+        error = "extension inconnue, .bmp ou .ppm attendu";
+        return false;
+    }
+
+    // L'écriture par ofstream ne passe pas par SDL : la cause est dans errno
+    errno = 0;
+    std::ofstream file(path, std::ios::binary);
+    file << "P6\n" << width << " " << height << "\n255\n";
+    std::vector<char> row(3 * (std::size_t)width);
+    for (int y = 0; y < height; y++)
+    {
+        const std::uint32_t *pixel = tiles.pixels() + (std::size_t)y * width;
+        for (int x = 0; x < width; x++)
+        {
+            row[3 * x] = (char)(pixel[x] >> 16);
+            row[3 * x + 1] = (char)(pixel[x] >> 8);
+            row[3 * x + 2] = (char)pixel[x];
+        }
+        file.write(row.data(), row.size());
+    }
+    file.close();
+    if (!file)
+        error = errno ? std::strerror(errno) : "erreur d'écriture";
+    return (bool)file;
+}
+
+/*
+   Rendu sans fenêtre ni boucle d'évènements, pour produire des images en
+   série sur une machine sans affichage :
+       VoronoiApp --render [--cells] LxH sites.txt image.bmp [sites2.txt image2.ppm ...]
+   Chaque diagramme est construit sur ce thread puis dessiné par TileRaster,
+   comme le rendu logiciel de la fenêtre. Retourne le nombre d'échecs.
+*/
+int rendHorsEcran(int argc, char **argv)
+{
+    int width = 0, height = 0;
+    char separator = 0;
+    int first = 2;
+    bool cells = argc > first && std::strcmp(argv[first], CELLS_OPTION) == 0;
+    if (cells)
+        first++;
+    bool usage = argc < first + 3 || (argc - first - 1) % 2 != 0
+        || std::sscanf(argv[first], "%d%c%d", &width, &separator, &height) != 3 || separator != 'x'
+        || width <= 0 || height <= 0 || width > TileRaster::MAX_SIZE || height > TileRaster::MAX_SIZE;
+    // Seuls BMP et PPM sont écrits : out.png serait un PPM mal nommé
+    for (int i = first + 2; !usage && i < argc; i += 2)
+    {
+        std::string extension = imageExtension(argv[i]);
+        usage = extension != ".bmp" && extension != ".ppm";
+    }
+    if (usage)
+    {
+        std::cerr << "Usage : " << argv[0] << " " << HEADLESS_OPTION << " [" << CELLS_OPTION
+                  << "] LARGEURxHAUTEUR sites.txt image.(bmp|ppm) [sites.txt image ...]" << std::endl;
+        return 1;
+    }
+
+    Triangulation diagram;
+    TileRaster tiles;
+    WorkerPool workers;
+    std::vector<Site> sites;
+    std::vector<int> visible;
+    std::vector<std::uint8_t> cellColors;
+    const Camera camera;
+    const ViewRect view = camera.visible(width, height, POINT_RADIUS + 1);
+    int failures = 0;
+    for (int i = first + 1; i + 1 < argc; i += 2)
+    {
+        if (!chargeSites(argv[i], sites))
+        {
+            std::cerr << "Impossible de lire " << argv[i] << std::endl;
+            failures++;
+            continue;
+        }
+        diagram.reset(0, 0, width, height);
+        diagram.insertBatch(std::move(sites));
+
+        if (cells)
+            coloreCellules(diagram, cellColors);
+        tiles.reset(width, height, BACKGROUND_COLOR);
+        rasteriseDiagram(tiles, visible, diagram, camera, view, cells ? &cellColors : nullptr);
+        tiles.render(workers);
+        std::string error;
+        if (!enregistreImage(tiles, argv[i + 1], error))
+        {
+            std::cerr << "Impossible d'écrire " << argv[i + 1] << " : " << error << std::endl;
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && std::strcmp(argv[1], HEADLESS_OPTION) == 0)
+        return rendHorsEcran(argc, argv);
+
     SDL_Window *gWindow;
     SDL_Renderer *renderer;
-    Application app{720, 720, Coords{0, 0}};
+    Graphics gfx;
+    Application app{720, 720, Camera{}};
     bool is_running = true;
 
     // Creation de la fenetre
@@ -345,31 +818,64 @@ int main()
         exit(1);
     }
 
-    renderer = SDL_CreateRenderer(gWindow, -1, 0); // SDL_RENDERER_PRESENTVSYNC
+    renderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_PRESENTVSYNC);
+    gfx.pointGlyph = createDiscTexture(renderer, POINT_RADIUS);
+
+    // Le worker réveille la boucle d'évènements à chaque diagramme terminé
+    app.diagramReady = SDL_RegisterEvents(1);
+    app.worker.setNotify([type = app.diagramReady]() {
+        SDL_Event ready{};
+        ready.type = type;
+        SDL_PushEvent(&ready);
+    });
+    app.diagram = app.worker.snapshot();
+    construitVoronoi(app);
+
+    // Le rendu logiciel dessine sur son thread et réveille la boucle à chaque image
+    app.frameReady = SDL_RegisterEvents(1);
+    gfx.raster.setDraw(rasteriseScene);
+    gfx.raster.setNotify([type = app.frameReady]() {
+        SDL_Event ready{};
+        ready.type = type;
+        SDL_PushEvent(&ready);
+    });
 
     /*  GAME LOOP  */
     while (true)
     {
-        // INPUTS
-        is_running = handleEvent(app);
+        // INPUTS, en dormant tant que rien n'a changé
+        is_running = handleEvent(app, !app.dirty);
         if (!is_running)
             break;
+        if (!app.dirty)
+            continue;
 
         // EFFACAGE FRAME
         SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
         SDL_RenderClear(renderer);
 
-        // DESSIN
-        draw(renderer, app);
+        // DESSIN, d'après un instantané de l'application
+        int width, height;
+        SDL_GetRendererOutputSize(renderer, &width, &height);
+        std::shared_ptr<const Scene> scene = figeScene(app, width, height);
+        draw(renderer, gfx, scene);
 
-        // VALIDATION FRAME
+        // VALIDATION FRAME, cadencée par la synchro verticale
         SDL_RenderPresent(renderer);
-
-        // PAUSE en ms
-        SDL_Delay(1000 / 30);
+        // Pendant un zoom, les images suivent jusqu'à celle qui redessine les calques
+        app.dirty = scene->zooming;
     }
 
     // Free resources and close SDL
+    app.worker.stop();
+    gfx.raster.stop();
+    gfx.raster.release();
+    SDL_DestroyTexture(gfx.pointGlyph);
+    gfx.cellsLayer.release();
+    gfx.pointsLayer.release();
+    gfx.edgesLayer.release();
+    gfx.trianglesLayer.release();
+    gfx.density.release();
     close(gWindow, renderer);
 
     return 0;
@@ -0,0 +1,104 @@
+#include "raster_worker.h"
+#include <atomic>
+
+RasterWorker::RasterWorker()
+{
+    thread_ = std::thread(&RasterWorker::run, this);
+}
+
+RasterWorker::~RasterWorker()
+{
+    stop();
+}
+
+void RasterWorker::setDraw(std::function<void(TileRaster&, const Scene&)> draw)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    draw_ = std::move(draw);
+}
+
+void RasterWorker::setNotify(std::function<void()> notify)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    notify_ = std::move(notify);
+}
+
+void RasterWorker::submit(std::shared_ptr<const Scene> scene)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = std::move(scene);
+    }
+    wake_.notify_one();
+}
+
+std::shared_ptr<RasterWorker::Frame> RasterWorker::frame() const
+{
+    return std::atomic_load(&published_);
+}
+
+void RasterWorker::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        pending_.reset();
+    }
+    wake_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void RasterWorker::release()
+{
+    for (const std::shared_ptr<Frame>& frame : pool_)
+        frame->tiles.release();
+}
+
+/*
+   Une image que seul le réservoir référence : ni publiée, ni gardée par
+   l'affichage, qui ne peut l'obtenir qu'en passant par published_.
+*/
+std::shared_ptr<RasterWorker::Frame> RasterWorker::freeFrame()
+{
+    for (const std::shared_ptr<Frame>& frame : pool_)
+    {
+        if (frame.use_count() == 1)
+        {
+            // Voit les lectures de l'affichage terminées avant de réécrire le framebuffer
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return frame;
+        }
+    }
+    pool_.push_back(std::make_shared<Frame>());
+    return pool_.back();
+}
+
+void RasterWorker::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        wake_.wait(lock, [this] { return stopping_ || pending_; });
+        if (stopping_)
+            return;
+
+        std::shared_ptr<const Scene> scene = std::move(pending_);
+        pending_.reset();
+        std::function<void(TileRaster&, const Scene&)> draw = draw_;
+        std::function<void()> notify = notify_;
+        lock.unlock();
+
+        std::shared_ptr<Frame> frame = freeFrame();
+        frame->scene = scene;
+        if (draw)
+            draw(frame->tiles, *scene);
+        frame->tiles.render(workers_);
+        std::atomic_store(&published_, frame);
+        frame.reset();
+        if (notify)
+            notify();
+
+        lock.lock();
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef RASTER_WORKER_H
+#define RASTER_WORKER_H
+#include "scene.h"
+#include "tile_raster.h"
+#include "worker_pool.h"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+   Rendu logiciel des scènes sur un thread dédié. Seule la dernière scène
+   soumise est dessinée ; chaque image terminée est publiée en remplaçant
+   atomiquement la précédente, comme les instantanés de DiagramWorker.
+   Les images tournent sur un petit réservoir (triple tampon) : une
+   affichée, une publiée, une en cours de dessin.
+*/
+class RasterWorker
+{
+public:
+    struct Frame
+    {
+        std::shared_ptr<const Scene> scene; // scène dessinée dans tiles
+        TileRaster tiles;
+    };
+
+    RasterWorker();
+    RasterWorker(const RasterWorker&) = delete;
+    RasterWorker& operator=(const RasterWorker&) = delete;
+    ~RasterWorker();
+
+    /* Enregistre les primitives d'une scène, appelé depuis le thread de rendu */
+    void setDraw(std::function<void(TileRaster&, const Scene&)> draw);
+    /* Appelé depuis le thread de rendu à chaque image publiée */
+    void setNotify(std::function<void()> notify);
+
+    /* Remplace la scène en attente, une scène en cours de dessin est terminée */
+    void submit(std::shared_ptr<const Scene> scene);
+
+    /*
+       Dernière image terminée, nulle avant la première. Tant que
+       l'appelant la garde, le thread de rendu n'y dessine pas : le
+       framebuffer peut être envoyé au renderer sans verrou.
+    */
+    std::shared_ptr<Frame> frame() const;
+
+    /* Arrête le thread, la scène en attente est abandonnée */
+    void stop();
+
+    /* Après stop(), avant de détruire le renderer qui possède les textures */
+    void release();
+
+private:
+    void run();
+    std::shared_ptr<Frame> freeFrame();
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::shared_ptr<const Scene> pending_;
+    bool stopping_ = false;
+    std::function<void(TileRaster&, const Scene&)> draw_;
+    std::function<void()> notify_;
+
+    // Propres au thread de rendu
+    std::vector<std::shared_ptr<Frame>> pool_;
+    WorkerPool workers_; // threads des tuiles, gardés d'une image à l'autre
+
+    std::shared_ptr<Frame> published_;
+    std::thread thread_;
+};
+
+#endif
@@ -0,0 +1,207 @@
+#include "render_batch.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Multiple de 3 : une tranche ne coupe jamais un triangle
+    const int MAX_INDICES_PER_CALL = 6 * 65536;
+}
+
+void RenderBatch::clear()
+{
+    vertices_.clear();
+    indices_.clear();
+}
+
+void RenderBatch::setClip(float minX, float minY, float maxX, float maxY)
+{
+    clipMinX_ = minX;
+    clipMinY_ = minY;
+    clipMaxX_ = maxX;
+    clipMaxY_ = maxY;
+}
+
+/* Liang-Barsky */
+bool RenderBatch::clipLine(float& x1, float& y1, float& x2, float& y2) const
+{
+    float dx = x2 - x1, dy = y2 - y1;
+    float t0 = 0, t1 = 1;
+    const float p[4] = {-dx, dx, -dy, dy};
+    const float q[4] = {x1 - clipMinX_, clipMaxX_ - x1, y1 - clipMinY_, clipMaxY_ - y1};
+    for (int i = 0; i < 4; i++)
+    {
+        if (p[i] == 0)
+        {
+            if (q[i] < 0)
+                return false;
+            continue;
+        }
+        float t = q[i] / p[i];
+        if (p[i] < 0)
+            t0 = std::max(t0, t);
+        else
+            t1 = std::min(t1, t);
+        if (t0 > t1)
+            return false;
+    }
+    x2 = x1 + t1 * dx;
+    y2 = y1 + t1 * dy;
+    x1 = x1 + t0 * dx;
+    y1 = y1 + t0 * dy;
+    return true;
+}
+
+void RenderBatch::addLine(float x1, float y1, float x2, float y2, SDL_Color color, float width)
+{
+    if (!clipLine(x1, y1, x2, y2))
+        return;
+
+    // Centre des pixels, et demi-pixel de plus aux extrémités comme SDL_RenderDrawLine
+    x1 += 0.5f;
+    y1 += 0.5f;
+    x2 += 0.5f;
+    y2 += 0.5f;
+    float dx = x2 - x1, dy = y2 - y1;
+    float length = std::sqrt(dx * dx + dy * dy);
+    if (length < 1e-6f)
+    {
+        dx = 1;
+        dy = 0;
+    }
+    else
+    {
+        dx /= length;
+        dy /= length;
+    }
+    float h = width / 2.0f;
+    float ex = dx * h, ey = dy * h; // le long de la ligne
+    float nx = -dy * h, ny = dx * h; // perpendiculaire
+
+    int base = (int)vertices_.size();
+    vertices_.push_back(SDL_Vertex{{x1 - ex + nx, y1 - ey + ny}, color, {0, 0}});
+    vertices_.push_back(SDL_Vertex{{x1 - ex - nx, y1 - ey - ny}, color, {0, 0}});
+    vertices_.push_back(SDL_Vertex{{x2 + ex - nx, y2 + ey - ny}, color, {0, 0}});
+    vertices_.push_back(SDL_Vertex{{x2 + ex + nx, y2 + ey + ny}, color, {0, 0}});
+    indices_.insert(indices_.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+}
+
+void RenderBatch::addTriangle(SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, SDL_Color color)
+{
+    if (std::max({a.x, b.x, c.x}) < clipMinX_ || std::min({a.x, b.x, c.x}) > clipMaxX_
+        || std::max({a.y, b.y, c.y}) < clipMinY_ || std::min({a.y, b.y, c.y}) > clipMaxY_)
+        return;
+
+    int base = (int)vertices_.size();
+    vertices_.push_back(SDL_Vertex{a, color, {0, 0}});
+    vertices_.push_back(SDL_Vertex{b, color, {0, 0}});
+    vertices_.push_back(SDL_Vertex{c, color, {0, 0}});
+    indices_.insert(indices_.end(), {base, base + 1, base + 2});
+}
+
+/* Sutherland-Hodgman sur un bord : garde x (y si vertical) >= bound si above, <= bound sinon */
+void RenderBatch::clipPolygon(const std::vector<SDL_FPoint>& in, std::vector<SDL_FPoint>& out, bool vertical, float bound, bool above) const
+{
+    out.clear();
+    for (std::size_t i = 0; i < in.size(); i++)
+    {
+        const SDL_FPoint& a = in[i];
+        const SDL_FPoint& b = in[(i + 1) % in.size()];
+        float va = vertical ? a.y : a.x, vb = vertical ? b.y : b.x;
+        bool insideA = above ? va >= bound : va <= bound;
+        bool insideB = above ? vb >= bound : vb <= bound;
+        if (insideA)
+            out.push_back(a);
+        if (insideA != insideB)
+        {
+            float t = (bound - va) / (vb - va);
+            out.push_back(SDL_FPoint{a.x + t * (b.x - a.x), a.y + t * (b.y - a.y)});
+        }
+    }
+}
+
+void RenderBatch::addPolygon(const SDL_FPoint *points, int count, SDL_Color color)
+{
+    if (count < 3)
+        return;
+
+    float minX = points[0].x, maxX = points[0].x, minY = points[0].y, maxY = points[0].y;
+    for (int i = 1; i < count; i++)
+    {
+        minX = std::min(minX, points[i].x);
+        maxX = std::max(maxX, points[i].x);
+        minY = std::min(minY, points[i].y);
+        maxY = std::max(maxY, points[i].y);
+    }
+    if (maxX < clipMinX_ || minX > clipMaxX_ || maxY < clipMinY_ || minY > clipMaxY_)
+        return;
+
+    if (minX < clipMinX_ || minY < clipMinY_ || maxX > clipMaxX_ || maxY > clipMaxY_)
+    {
+        clipped_[0].assign(points, points + count);
+        clipPolygon(clipped_[0], clipped_[1], false, clipMinX_, true);
+        clipPolygon(clipped_[1], clipped_[0], false, clipMaxX_, false);
+        clipPolygon(clipped_[0], clipped_[1], true, clipMinY_, true);
+        clipPolygon(clipped_[1], clipped_[0], true, clipMaxY_, false);
+        if (clipped_[0].size() < 3)
+            return;
+        points = clipped_[0].data();
+        count = (int)clipped_[0].size();
+    }
+
+    int base = (int)vertices_.size();
+    for (int i = 0; i < count; i++)
+        vertices_.push_back(SDL_Vertex{points[i], color, {0, 0}});
+    for (int i = 1; i + 1 < count; i++)
+        indices_.insert(indices_.end(), {base, base + i, base + i + 1});
+}
+
+void RenderBatch::addSprite(float x, float y, float w, float h, SDL_Color color)
+{
+    if (x + w < clipMinX_ || x > clipMaxX_ || y + h < clipMinY_ || y > clipMaxY_)
+        return;
+
+    int base = (int)vertices_.size();
+    vertices_.push_back(SDL_Vertex{{x, y}, color, {0, 0}});
+    vertices_.push_back(SDL_Vertex{{x + w, y}, color, {1, 0}});
+    vertices_.push_back(SDL_Vertex{{x + w, y + h}, color, {1, 1}});
+    vertices_.push_back(SDL_Vertex{{x, y + h}, color, {0, 1}});
+    indices_.insert(indices_.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+}
+
+int RenderBatch::submit(SDL_Renderer *renderer, SDL_Texture *texture) const
+{
+    int result = 0;
+    int total = (int)indices_.size();
+    for (int first = 0; first < total; first += MAX_INDICES_PER_CALL)
+    {
+        int count = std::min(MAX_INDICES_PER_CALL, total - first);
+        result |= SDL_RenderGeometry(renderer, texture,
+            vertices_.data(), (int)vertices_.size(), indices_.data() + first, count);
+    }
+    return result;
+}
+
+SDL_Texture *createDiscTexture(SDL_Renderer *renderer, int radius)
+{
+    int size = 2 * radius + 1;
+    std::vector<Uint32> pixels((std::size_t)size * size, 0);
+    for (int y = -radius; y <= radius; y++)
+    {
+        for (int x = -radius; x <= radius; x++)
+        {
+            if (x * x + y * y <= radius * radius + radius)
+                pixels[(std::size_t)(y + radius) * size + (x + radius)] = 0xFFFFFFFF;
+        }
+    }
+
+    SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, size, size);
+    if (texture == NULL)
+    {
+        SDL_Log("Unable to create point texture! SDL Error: %s\n", SDL_GetError());
+        return NULL;
+    }
+    SDL_UpdateTexture(texture, NULL, pixels.data(), size * (int)sizeof(Uint32));
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    return texture;
+}
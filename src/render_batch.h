@@ -0,0 +1,48 @@
+#ifndef RENDER_BATCH_H
+#define RENDER_BATCH_H
+#include <SDL2/SDL.h>
+#include <vector>
+
+/*
+   Tampon de sommets et d'indices envoyé en un seul SDL_RenderGeometry.
+   Les lignes deviennent des quadrilatères fins découpés par la zone de
+   découpe, les tampons gardent leur capacité d'une image à l'autre.
+*/
+class RenderBatch
+{
+public:
+    void clear();
+    bool empty() const { return indices_.empty(); }
+
+    /* Zone visible : les primitives en dehors ne sont pas ajoutées */
+    void setClip(float minX, float minY, float maxX, float maxY);
+
+    void addLine(float x1, float y1, float x2, float y2, SDL_Color color, float width = 1.0f);
+    void addTriangle(SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, SDL_Color color);
+
+    /* Polygone convexe, découpé par la zone de découpe puis ajouté en éventail */
+    void addPolygon(const SDL_FPoint *points, int count, SDL_Color color);
+
+    /* Quadrilatère texturé de (x, y) à (x + w, y + h), teinté par color */
+    void addSprite(float x, float y, float w, float h, SDL_Color color);
+
+    /* Envoie tout le lot, par tranches bornées pour les très gros maillages */
+    int submit(SDL_Renderer *renderer, SDL_Texture *texture = nullptr) const;
+
+private:
+    bool clipLine(float& x1, float& y1, float& x2, float& y2) const;
+    void clipPolygon(const std::vector<SDL_FPoint>& in, std::vector<SDL_FPoint>& out, bool vertical, float bound, bool above) const;
+
+    float clipMinX_ = -16384, clipMinY_ = -16384, clipMaxX_ = 16384, clipMaxY_ = 16384;
+    std::vector<SDL_Vertex> vertices_;
+    std::vector<int> indices_;
+    std::vector<SDL_FPoint> clipped_[2]; // tampons du découpage des polygones
+};
+
+/*
+   Disque blanc de rayon radius (mêmes pixels que filledCircleRGBA), à
+   teinter par la couleur des sommets. (2 * radius + 1) pixels de côté.
+*/
+SDL_Texture *createDiscTexture(SDL_Renderer *renderer, int radius);
+
+#endif
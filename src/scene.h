@@ -0,0 +1,31 @@
+#ifndef SCENE_H
+#define SCENE_H
+#include "triangulation.h"
+#include "camera.h"
+#include <memory>
+
+/*
+   Instantané figé de ce qu'affiche la fenêtre. La boucle d'évènements en
+   publie un nouveau à chaque changement ; l'affichage et le thread de
+   rendu logiciel ne lisent que lui, jamais l'état de l'application.
+*/
+struct Scene
+{
+    std::shared_ptr<const Triangulation> diagram; // jamais nul
+    Camera camera;
+    int width = 0, height = 0; // taille de la sortie en pixels
+    int hovered = Triangulation::NONE;
+    int hoveredTriangle = Triangulation::NONE;
+    bool software = false;
+    bool cells = false;
+    bool zooming = false; // molette en cours : les calques sont étirés plutôt que redessinés
+
+    /* Même image hors survol : le rendu logiciel peut être réutilisé */
+    bool sameImage(const Scene& other) const
+    {
+        return diagram == other.diagram && camera == other.camera && width == other.width
+            && height == other.height && cells == other.cells;
+    }
+};
+
+#endif
@@ -0,0 +1,310 @@
+#include "tile_raster.h"
+#include "SDL2_gfxPrimitives.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+    // Marge hors du framebuffer : les primitives qui la dépassent sont
+    // découpées, pour que leurs coordonnées tiennent sur 16 bits
+    const float GUARD = 8;
+
+    /* Sutherland-Hodgman sur un bord : garde x (y si vertical) >= bound si above, <= bound sinon */
+    void clipPolygon(const std::vector<SDL_FPoint>& in, std::vector<SDL_FPoint>& out, bool vertical, float bound, bool above)
+    {
+        out.clear();
+        for (std::size_t i = 0; i < in.size(); i++)
+        {
+            const SDL_FPoint& a = in[i];
+            const SDL_FPoint& b = in[(i + 1) % in.size()];
+            float va = vertical ? a.y : a.x, vb = vertical ? b.y : b.x;
+            bool insideA = above ? va >= bound : va <= bound;
+            bool insideB = above ? vb >= bound : vb <= bound;
+            if (insideA)
+                out.push_back(a);
+            if (insideA != insideB)
+            {
+                float t = (bound - va) / (vb - va);
+                out.push_back(SDL_FPoint{a.x + t * (b.x - a.x), a.y + t * (b.y - a.y)});
+            }
+        }
+    }
+
+    /* Liang-Barsky */
+    bool clipLine(float& x1, float& y1, float& x2, float& y2, float minX, float minY, float maxX, float maxY)
+    {
+        float dx = x2 - x1, dy = y2 - y1;
+        float t0 = 0, t1 = 1;
+        const float p[4] = {-dx, dx, -dy, dy};
+        const float q[4] = {x1 - minX, maxX - x1, y1 - minY, maxY - y1};
+        for (int i = 0; i < 4; i++)
+        {
+            if (p[i] == 0)
+            {
+                if (q[i] < 0)
+                    return false;
+                continue;
+            }
+            float t = q[i] / p[i];
+            if (p[i] < 0)
+                t0 = std::max(t0, t);
+            else
+                t1 = std::min(t1, t);
+            if (t0 > t1)
+                return false;
+        }
+        x2 = x1 + t1 * dx;
+        y2 = y1 + t1 * dy;
+        x1 = x1 + t0 * dx;
+        y1 = y1 + t0 * dy;
+        return true;
+    }
+}
+
+TileRaster::~TileRaster()
+{
+    release();
+    for (int *scratch : scratch_)
+        free(scratch);
+}
+
+void TileRaster::release()
+{
+    if (texture_)
+        SDL_DestroyTexture(texture_);
+    texture_ = nullptr;
+    textureWidth_ = textureHeight_ = 0;
+}
+
+void TileRaster::reset(int width, int height, SDL_Color background)
+{
+    width = std::clamp(width, 0, MAX_SIZE);
+    height = std::clamp(height, 0, MAX_SIZE);
+    if (width != width_ || height != height_)
+    {
+        width_ = width;
+        height_ = height;
+        tilesX_ = (width_ + TILE_SIZE - 1) / TILE_SIZE;
+        tilesY_ = (height_ + TILE_SIZE - 1) / TILE_SIZE;
+        pixels_.assign((std::size_t)width_ * height_, 0);
+    }
+    background_ = ((std::uint32_t)background.a << 24) | ((std::uint32_t)background.r << 16)
+        | ((std::uint32_t)background.g << 8) | background.b;
+    commands_.clear();
+    xs_.clear();
+    ys_.clear();
+}
+
+void TileRaster::push(Kind kind, SDL_Color color, int first, int count)
+{
+    Command cmd{kind, color, first, count, 0, 0, 0, 0};
+    if (kind == DISC)
+    {
+        cmd.minX = xs_[first] - count;
+        cmd.maxX = xs_[first] + count;
+        cmd.minY = ys_[first] - count;
+        cmd.maxY = ys_[first] + count;
+    }
+    else
+    {
+        auto xs = std::minmax_element(xs_.begin() + first, xs_.begin() + first + count);
+        auto ys = std::minmax_element(ys_.begin() + first, ys_.begin() + first + count);
+        cmd.minX = *xs.first;
+        cmd.maxX = *xs.second;
+        cmd.minY = *ys.first;
+        cmd.maxY = *ys.second;
+    }
+    if (cmd.maxX < 0 || cmd.maxY < 0 || cmd.minX >= width_ || cmd.minY >= height_)
+    {
+        xs_.resize(first);
+        ys_.resize(first);
+        return;
+    }
+    commands_.push_back(cmd);
+}
+
+void TileRaster::addTriangle(float x1, float y1, float x2, float y2, float x3, float y3, SDL_Color color)
+{
+    const SDL_FPoint points[3] = {{x1, y1}, {x2, y2}, {x3, y3}};
+    addPolygon(points, 3, color);
+}
+
+void TileRaster::addPolygon(const SDL_FPoint *points, int count, SDL_Color color)
+{
+    if (count < 3)
+        return;
+
+    float minX = points[0].x, maxX = points[0].x, minY = points[0].y, maxY = points[0].y;
+    for (int i = 1; i < count; i++)
+    {
+        minX = std::min(minX, points[i].x);
+        maxX = std::max(maxX, points[i].x);
+        minY = std::min(minY, points[i].y);
+        maxY = std::max(maxY, points[i].y);
+    }
+    if (maxX < 0 || maxY < 0 || minX >= width_ || minY >= height_)
+        return;
+
+    if (minX < -GUARD || minY < -GUARD || maxX > width_ + GUARD || maxY > height_ + GUARD)
+    {
+        clipped_[0].assign(points, points + count);
+        clipPolygon(clipped_[0], clipped_[1], false, -GUARD, true);
+        clipPolygon(clipped_[1], clipped_[0], false, width_ + GUARD, false);
+        clipPolygon(clipped_[0], clipped_[1], true, -GUARD, true);
+        clipPolygon(clipped_[1], clipped_[0], true, height_ + GUARD, false);
+        if (clipped_[0].size() < 3)
+            return;
+        points = clipped_[0].data();
+        count = (int)clipped_[0].size();
+    }
+
+    int first = (int)xs_.size();
+    for (int i = 0; i < count; i++)
+    {
+        xs_.push_back((Sint16)std::lround(points[i].x));
+        ys_.push_back((Sint16)std::lround(points[i].y));
+    }
+    push(POLYGON, color, first, count);
+}
+
+void TileRaster::addLine(float x1, float y1, float x2, float y2, SDL_Color color, bool antialiased)
+{
+    if (!clipLine(x1, y1, x2, y2, -GUARD, -GUARD, width_ + GUARD, height_ + GUARD))
+        return;
+    int first = (int)xs_.size();
+    xs_.push_back((Sint16)std::lround(x1));
+    ys_.push_back((Sint16)std::lround(y1));
+    xs_.push_back((Sint16)std::lround(x2));
+    ys_.push_back((Sint16)std::lround(y2));
+    push(antialiased ? AALINE : LINE, color, first, 2);
+}
+
+void TileRaster::addDisc(float x, float y, int radius, SDL_Color color)
+{
+    radius = std::max(radius, 0);
+    if (x + radius < 0 || y + radius < 0 || x - radius >= width_ || y - radius >= height_)
+        return;
+
+    // Un disque qui dépasse la marge devient un polygone, découpé comme les autres
+    if (x - radius < -GUARD || y - radius < -GUARD || x + radius > width_ + GUARD || y + radius > height_ + GUARD)
+    {
+        // Écart au cercle sous le quart de pixel
+        const float pi = 3.14159265f;
+        int sides = std::clamp((int)std::ceil(pi / std::acos(1 - 0.25f / radius)), 16, 4096);
+        outline_.clear();
+        for (int i = 0; i < sides; i++)
+        {
+            float angle = 2 * pi * i / sides;
+            outline_.push_back(SDL_FPoint{x + radius * std::cos(angle), y + radius * std::sin(angle)});
+        }
+        addPolygon(outline_.data(), sides, color);
+        return;
+    }
+
+    int first = (int)xs_.size();
+    xs_.push_back((Sint16)std::lround(x));
+    ys_.push_back((Sint16)std::lround(y));
+    push(DISC, color, first, radius);
+}
+
+void TileRaster::render(WorkerPool& workers)
+{
+    const unsigned threads = workers.size();
+    const int tiles = tilesX_ * tilesY_;
+    if (tiles == 0)
+        return;
+
+    // Rangement par tranches contiguës de primitives : en lisant les tranches
+    // dans l'ordre, une tuile retrouve ses primitives dans l'ordre d'ajout
+    const int count = (int)commands_.size();
+    unsigned slices = std::max(1u, std::min<unsigned>(threads, count));
+    bins_.resize((std::size_t)slices * tiles);
+    parallelFor(workers, count, [&](int begin, int end, unsigned slice) {
+        std::vector<int> *bins = &bins_[(std::size_t)slice * tiles];
+        for (int t = 0; t < tiles; t++)
+            bins[t].clear();
+        for (int c = begin; c < end; c++)
+        {
+            const Command& cmd = commands_[c];
+            int tx1 = std::max(cmd.minX, 0) / TILE_SIZE, tx2 = std::min(cmd.maxX, width_ - 1) / TILE_SIZE;
+            int ty1 = std::max(cmd.minY, 0) / TILE_SIZE, ty2 = std::min(cmd.maxY, height_ - 1) / TILE_SIZE;
+            for (int ty = ty1; ty <= ty2; ty++)
+                for (int tx = tx1; tx <= tx2; tx++)
+                    bins[ty * tilesX_ + tx].push_back(c);
+        }
+    }, slices);
+
+    // Tuiles distribuées à la demande, leur coût variant avec la scène
+    scratch_.resize(threads, nullptr);
+    scratchSize_.resize(threads, 0);
+    std::atomic<int> next{0};
+    workers.run(threads, [&](unsigned worker) {
+        for (int tile = next++; tile < tiles; tile = next++)
+            drawTile(tile, worker, slices);
+    });
+}
+
+void TileRaster::drawTile(int tile, unsigned worker, unsigned slices)
+{
+    const int tiles = tilesX_ * tilesY_;
+    SDL_Rect clip;
+    clip.x = (tile % tilesX_) * TILE_SIZE;
+    clip.y = (tile / tilesX_) * TILE_SIZE;
+    clip.w = std::min(TILE_SIZE, width_ - clip.x);
+    clip.h = std::min(TILE_SIZE, height_ - clip.y);
+    for (int y = clip.y; y < clip.y + clip.h; y++)
+        std::fill_n(&pixels_[(std::size_t)y * width_ + clip.x], clip.w, background_);
+
+    SDL2_gfxBatch batch;
+    gfxBatchBeginPixels(&batch, pixels_.data(), width_, height_, width_, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    gfxBatchSetClip(&batch, &clip);
+    for (unsigned slice = 0; slice < slices; slice++)
+    {
+        for (int c : bins_[(std::size_t)slice * tiles + tile])
+        {
+            const Command& cmd = commands_[c];
+            gfxBatchColor(&batch, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a);
+            switch (cmd.kind)
+            {
+            case POLYGON:
+                filledPolygonBatchMT(&batch, &xs_[cmd.first], &ys_[cmd.first], cmd.count,
+                    &scratch_[worker], &scratchSize_[worker]);
+                break;
+            case LINE:
+                lineBatch(&batch, xs_[cmd.first], ys_[cmd.first], xs_[cmd.first + 1], ys_[cmd.first + 1]);
+                break;
+            case AALINE:
+                aalineBatch(&batch, xs_[cmd.first], ys_[cmd.first], xs_[cmd.first + 1], ys_[cmd.first + 1]);
+                break;
+            case DISC:
+                filledCircleBatch(&batch, xs_[cmd.first], ys_[cmd.first], cmd.count);
+                break;
+            }
+        }
+    }
+    gfxBatchEnd(&batch);
+}
+
+void TileRaster::submit(SDL_Renderer *renderer)
+{
+    if (width_ == 0 || height_ == 0)
+        return;
+
+    if (!texture_ || textureWidth_ != width_ || textureHeight_ != height_)
+    {
+        release();
+        texture_ = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width_, height_);
+        if (texture_ == NULL)
+        {
+            SDL_Log("Unable to create raster texture! SDL Error: %s\n", SDL_GetError());
+            return;
+        }
+        SDL_SetTextureBlendMode(texture_, SDL_BLENDMODE_BLEND);
+        textureWidth_ = width_;
+        textureHeight_ = height_;
+    }
+    SDL_UpdateTexture(texture_, NULL, pixels_.data(), width_ * (int)sizeof(std::uint32_t));
+    SDL_RenderCopy(renderer, texture_, NULL, NULL);
+}
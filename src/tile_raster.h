@@ -0,0 +1,95 @@
+#ifndef TILE_RASTER_H
+#define TILE_RASTER_H
+#include "worker_pool.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <vector>
+
+/*
+   Rendu logiciel dans un framebuffer ARGB8888, découpé en tuiles. Les
+   primitives sont d'abord enregistrées, puis rangées par tuile et
+   dessinées par les threads d'un WorkerPool avec les lots logiciels de
+   SDL2_gfxPrimitives. Chaque tuile n'est écrite que par un seul thread,
+   dans l'ordre d'ajout des primitives : ni verrou ni couture.
+*/
+class TileRaster
+{
+public:
+    static constexpr int TILE_SIZE = 128;
+    // Les primitives gfx ont des coordonnées sur 16 bits
+    static constexpr int MAX_SIZE = 16384;
+
+    TileRaster() = default;
+    TileRaster(const TileRaster&) = delete;
+    TileRaster& operator=(const TileRaster&) = delete;
+    ~TileRaster();
+
+    /* Oublie les primitives, redimensionne si la sortie a changé (au plus MAX_SIZE) */
+    void reset(int width, int height, SDL_Color background);
+
+    /*
+       Coordonnées en pixels, les primitives hors du framebuffer sont ignorées.
+       Celles qui dépassent la marge autour du framebuffer sont découpées ;
+       un disque l'est en polygone à la place d'un cercle gfx.
+    */
+    void addTriangle(float x1, float y1, float x2, float y2, float x3, float y3, SDL_Color color);
+    void addPolygon(const SDL_FPoint *points, int count, SDL_Color color);
+    void addLine(float x1, float y1, float x2, float y2, SDL_Color color, bool antialiased = false);
+    void addDisc(float x, float y, int radius, SDL_Color color);
+
+    /* Dessine toutes les primitives sur les threads du réservoir */
+    void render(WorkerPool& workers);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int primitiveCount() const { return (int)commands_.size(); }
+
+    /* width() pixels par ligne, valides après render() */
+    const std::uint32_t *pixels() const { return pixels_.data(); }
+
+    /* Copie le framebuffer dans une texture et l'affiche en un SDL_RenderCopy */
+    void submit(SDL_Renderer *renderer);
+
+    /* À appeler avant de détruire le renderer, qui libère ses textures */
+    void release();
+
+private:
+    enum Kind : std::uint8_t
+    {
+        POLYGON,
+        LINE,
+        AALINE,
+        DISC
+    };
+
+    struct Command
+    {
+        Kind kind;
+        SDL_Color color;
+        int first, count; // sommets dans xs_ et ys_ ; le rayon pour un disque
+        int minX, minY, maxX, maxY; // boîte englobante en pixels
+    };
+
+    void push(Kind kind, SDL_Color color, int first, int count);
+    void drawTile(int tile, unsigned worker, unsigned slices);
+
+    int width_ = 0, height_ = 0;
+    int tilesX_ = 0, tilesY_ = 0;
+    std::uint32_t background_ = 0;
+    std::vector<std::uint32_t> pixels_;
+    std::vector<Command> commands_;
+    std::vector<Sint16> xs_, ys_;
+    std::vector<SDL_FPoint> clipped_[2]; // tampons du découpage des polygones
+    std::vector<SDL_FPoint> outline_;    // contour d'un disque découpé
+
+    // bins_[slice * tuiles + tuile] : primitives de la tranche qui touchent la tuile
+    std::vector<std::vector<int>> bins_;
+    // Tampons des polygones gfx, un par thread
+    std::vector<int *> scratch_;
+    std::vector<int> scratchSize_;
+
+    SDL_Texture *texture_ = nullptr;
+    int textureWidth_ = 0, textureHeight_ = 0;
+};
+
+#endif
@@ -0,0 +1,652 @@
+#include "voronoi_core.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+/*
+   Tests du cœur de calcul, sans SDL ni bibliothèque de test : chaque
+   vérification ratée est affichée et le code de retour compte les échecs.
+*/
+static int failures = 0;
+
+#define CHECK(condition, ...)                                         \
+    do                                                                \
+    {                                                                 \
+        if (!(condition))                                             \
+        {                                                             \
+            std::printf("%s:%d: ", __FILE__, __LINE__);               \
+            std::printf(__VA_ARGS__);                                 \
+            std::printf("\n");                                        \
+            failures++;                                               \
+        }                                                             \
+    } while (0)
+
+static const double SIZE = 1000;
+
+static std::vector<Site> randomSites(std::mt19937& rng, int count, double maxWeight = 0)
+{
+    std::uniform_real_distribution<double> coord(0, SIZE);
+    std::uniform_real_distribution<double> weight(0, maxWeight);
+    std::vector<Site> sites;
+    for (int i = 0; i < count; i++)
+        sites.push_back(Site{coord(rng), coord(rng), maxWeight > 0 ? weight(rng) : 0});
+    return sites;
+}
+
+static double power(const Site& s, double x, double y)
+{
+    double dx = s.x - x, dy = s.y - y;
+    return dx * dx + dy * dy - s.w;
+}
+
+/* Aucun site n'est en conflit avec le cercle (de puissance) d'une face réelle */
+static bool isRegular(const Triangulation& diagram)
+{
+    for (int f = 0; f < diagram.faceCount(); f++)
+    {
+        const Triangulation::Face& t = diagram.face(f);
+        if (!t.alive || diagram.isSuper(t.v[0]) || diagram.isSuper(t.v[1]) || diagram.isSuper(t.v[2]))
+            continue;
+        Site c = powerCenter(diagram.site(t.v[0]), diagram.site(t.v[1]), diagram.site(t.v[2]));
+        double radius = power(diagram.site(t.v[0]), c.x, c.y);
+        for (int v = 3; v < diagram.vertexCount(); v++)
+        {
+            if (v == t.v[0] || v == t.v[1] || v == t.v[2])
+                continue;
+            if (power(diagram.site(v), c.x, c.y) < radius - 1e-7 * (1 + std::fabs(radius)))
+            {
+                std::printf("site %d en conflit avec la face %d\n", v, f);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* Multiensemble de segments, indépendant du sens de parcours */
+using SegmentKey = std::array<int, 4>;
+using SegmentCount = std::map<SegmentKey, int>;
+
+static SegmentKey key(const Segment& s)
+{
+    Coords a = s.p1, b = s.p2;
+    if (b.x < a.x || (b.x == a.x && b.y < a.y))
+        std::swap(a, b);
+    return SegmentKey{a.x, a.y, b.x, b.y};
+}
+
+static void record(SegmentCount& mirror, const VoronoiChangeSet& changes)
+{
+    for (const Segment& s : changes.added)
+        mirror[key(s)]++;
+    for (const Segment& s : changes.removed)
+        mirror[key(s)]--;
+}
+
+static SegmentCount count(const Triangulation& diagram)
+{
+    SegmentCount result;
+    for (std::size_t i = 0; i < diagram.segments().size(); i++)
+        result[key(diagram.segments()[i])]++;
+    return result;
+}
+
+static bool sameSegments(SegmentCount mirror, const Triangulation& diagram)
+{
+    for (auto it = mirror.begin(); it != mirror.end();)
+    {
+        if (it->second < 0)
+            return false;
+        it = it->second == 0 ? mirror.erase(it) : std::next(it);
+    }
+    return mirror == count(diagram);
+}
+
+static void testInsert()
+{
+    std::mt19937 rng(1);
+    Triangulation diagram;
+    diagram.reset(0, 0, SIZE, SIZE);
+    SegmentCount mirror;
+    VoronoiChangeSet changes;
+    std::vector<Site> sites = randomSites(rng, 400);
+    for (std::size_t i = 0; i < sites.size(); i++)
+    {
+        changes.clear();
+        CHECK(diagram.insert(sites[i], &changes) == (int)i + 3, "insert %zu : mauvais sommet", i);
+        record(mirror, changes);
+    }
+    CHECK(isRegular(diagram), "insert : triangulation non Delaunay");
+    CHECK(sameSegments(mirror, diagram), "insert : le miroir des changements diffère de segments()");
+
+    // Un doublon retourne le sommet existant
+    CHECK(diagram.insert(sites[10]) == 13, "insert : doublon non reconnu");
+
+    // Un doublon plus lourd remplace l'ancien sommet, un plus léger est ignoré
+    Site heavier{sites[20].x, sites[20].y, 5};
+    int v = diagram.insert(heavier);
+    CHECK(v == diagram.vertexCount() - 1 && diagram.site(v).w == 5, "insert : doublon plus lourd ignoré");
+    CHECK(diagram.isHidden(23) && !diagram.isHidden(v), "insert : l'ancien sommet reste visible");
+    CHECK(diagram.insert(sites[20]) == v, "insert : doublon plus léger ajouté");
+    CHECK(isRegular(diagram), "insert : doublon plus lourd, triangulation non régulière");
+    SiteLocator locator;
+    CHECK(locator.nearestSite(diagram, heavier.x + 0.5, heavier.y) == v, "insert : mauvaise cellule pour le doublon");
+}
+
+static void testInsertBatch()
+{
+    std::mt19937 rng(2);
+    for (double maxWeight : {0.0, 400.0})
+    {
+        Triangulation diagram;
+        diagram.reset(0, 0, SIZE, SIZE);
+        SegmentCount mirror;
+        VoronoiChangeSet changes;
+        CHECK(diagram.insertBatch(randomSites(rng, 300, maxWeight), &changes), "insertBatch interrompu");
+        record(mirror, changes);
+        changes.clear();
+        CHECK(diagram.insertBatch(randomSites(rng, 3000, maxWeight), &changes), "insertBatch interrompu");
+        record(mirror, changes);
+        CHECK(diagram.siteCount() == 3300, "insertBatch : %d sites", diagram.siteCount());
+        CHECK(isRegular(diagram), "insertBatch : triangulation non régulière (poids %g)", maxWeight);
+        CHECK(sameSegments(mirror, diagram), "insertBatch : le miroir des changements diffère de segments()");
+    }
+}
+
+static void checkMoved(const Triangulation& diagram, const std::vector<Site>& positions, const std::vector<Site>& before)
+{
+    for (std::size_t k = 0; k < positions.size(); k++)
+    {
+        const Site& s = diagram.site((int)k + 3);
+        CHECK(s.x == positions[k].x && s.y == positions[k].y && s.w == before[k].w,
+            "moveSites : le sommet %zu n'est plus le site %zu", k + 3, k);
+    }
+}
+
+static void testMoveSites()
+{
+    std::mt19937 rng(3);
+    Triangulation diagram;
+    diagram.reset(0, 0, SIZE, SIZE);
+    diagram.insertBatch(randomSites(rng, 500, 100));
+
+    // insertBatch insère dans l'ordre de Hilbert : on repart des sommets
+    std::vector<Site> sites;
+    for (int v = 3; v < diagram.vertexCount(); v++)
+        sites.push_back(diagram.site(v));
+
+    // Petits déplacements : réparés par bascules
+    std::normal_distribution<double> jitter(0, 2);
+    std::vector<Site> positions = sites;
+    for (Site& s : positions)
+    {
+        s.x = std::clamp(s.x + jitter(rng), 0.0, SIZE);
+        s.y = std::clamp(s.y + jitter(rng), 0.0, SIZE);
+    }
+    diagram.moveSites(positions);
+    checkMoved(diagram, positions, sites);
+    CHECK(isRegular(diagram), "moveSites (bascules) : triangulation non régulière");
+    CHECK(count(diagram) == count(Triangulation(diagram)), "moveSites : copie différente");
+
+    // Déplacements arbitraires et un site confondu : reconstruction possible
+    std::vector<Site> jumped = randomSites(rng, 500);
+    jumped[7] = jumped[3];
+    diagram.moveSites(jumped);
+    checkMoved(diagram, jumped, sites);
+    CHECK(isRegular(diagram), "moveSites (sauts) : triangulation non régulière");
+    int lighter = sites[3].w < sites[7].w ? 3 + 3 : 7 + 3;
+    CHECK(diagram.isHidden(lighter) && !diagram.isHidden(3 + 3 + 7 + 3 - lighter),
+        "moveSites : de deux sites confondus, le plus lourd doit rester visible");
+}
+
+static void testSnapshot()
+{
+    std::mt19937 rng(4);
+    Triangulation diagram;
+    diagram.reset(0, 0, SIZE, SIZE);
+    diagram.insertBatch(randomSites(rng, 600));
+    Triangulation snapshot = diagram;
+    SegmentCount frozen = count(snapshot);
+
+    diagram.insertBatch(randomSites(rng, 600));
+    diagram.moveSites(randomSites(rng, 1200));
+    CHECK(count(snapshot) == frozen, "copie modifiée par l'original");
+    CHECK(snapshot.siteCount() == 600 && isRegular(snapshot), "copie incohérente");
+}
+
+static bool touches(int minX, int minY, int maxX, int maxY, const double rect[4], double margin)
+{
+    return minX <= rect[2] + margin && maxX >= rect[0] - margin && minY <= rect[3] + margin && maxY >= rect[1] - margin;
+}
+
+/*
+   segmentsIn, trianglesIn et triangleAt contre un parcours complet. Les
+   boîtes des triangles viennent des sites, pas des coordonnées arrondies
+   de triangles() : d'où la marge d'un pixel.
+*/
+static void checkSpatialQueries(const Triangulation& diagram, std::mt19937& rng, const char *stage)
+{
+    std::uniform_real_distribution<double> coord(-100, SIZE + 100);
+    std::uniform_real_distribution<double> extent(0, 150);
+    const SharedArray<Segment>& segments = diagram.segments();
+    const SharedArray<Triangle>& triangles = diagram.triangles();
+    std::vector<int> found;
+    for (int q = 0; q < 200; q++)
+    {
+        double x = coord(rng), y = coord(rng);
+        const double rect[4] = {x, y, x + extent(rng), y + extent(rng)};
+
+        found.clear();
+        diagram.segmentsIn(rect[0], rect[1], rect[2], rect[3], found);
+        std::vector<bool> hit(segments.size(), false);
+        bool valid = true;
+        for (int k : found)
+        {
+            valid = valid && k >= 0 && k < (int)segments.size() && !hit[k];
+            if (valid)
+                hit[k] = true;
+        }
+        for (std::size_t k = 0; valid && k < segments.size(); k++)
+        {
+            const Segment& e = segments[k];
+            bool expected = touches(std::min(e.p1.x, e.p2.x), std::min(e.p1.y, e.p2.y),
+                std::max(e.p1.x, e.p2.x), std::max(e.p1.y, e.p2.y), rect, 0);
+            valid = hit[k] == expected;
+        }
+        CHECK(valid, "segmentsIn (%s) : diffère du parcours complet", stage);
+
+        found.clear();
+        diagram.trianglesIn(rect[0], rect[1], rect[2], rect[3], found);
+        hit.assign(triangles.size(), false);
+        valid = true;
+        for (int k : found)
+        {
+            valid = valid && k >= 0 && k < (int)triangles.size() && !hit[k];
+            if (valid)
+                hit[k] = true;
+        }
+        for (std::size_t k = 0; valid && k < triangles.size(); k++)
+        {
+            const Triangle& t = triangles[k];
+            int minX = std::min({t.p1.x, t.p2.x, t.p3.x}), maxX = std::max({t.p1.x, t.p2.x, t.p3.x});
+            int minY = std::min({t.p1.y, t.p2.y, t.p3.y}), maxY = std::max({t.p1.y, t.p2.y, t.p3.y});
+            if (hit[k])
+                valid = touches(minX, minY, maxX, maxY, rect, 1);
+            else
+                valid = !touches(minX + 1, minY + 1, maxX - 1, maxY - 1, rect, 0);
+        }
+        CHECK(valid, "trianglesIn (%s) : diffère du parcours complet", stage);
+    }
+
+    // Distance signée de (x, y) au côté ab, positive à gauche
+    auto side = [](const Coords& a, const Coords& b, double x, double y) {
+        double dx = b.x - a.x, dy = b.y - a.y;
+        return (dx * (y - a.y) - dy * (x - a.x)) / std::max(1e-9, std::hypot(dx, dy));
+    };
+    auto inside = [&](const Triangle& t, double x, double y, double margin) {
+        double sign = side(t.p1, t.p2, t.p3.x, t.p3.y) < 0 ? -1 : 1;
+        return sign * side(t.p1, t.p2, x, y) >= margin && sign * side(t.p2, t.p3, x, y) >= margin
+            && sign * side(t.p3, t.p1, x, y) >= margin;
+    };
+    for (int q = 0; q < 1000; q++)
+    {
+        double x = coord(rng), y = coord(rng);
+        int at = diagram.triangleAt(x, y);
+        int expected = Triangulation::NONE;
+        for (std::size_t k = 0; k < triangles.size(); k++)
+        {
+            if (inside(triangles[k], x, y, 1))
+                expected = (int)k;
+        }
+        bool valid = at == Triangulation::NONE || (at >= 0 && at < (int)triangles.size() && inside(triangles[at], x, y, -1));
+        if (expected != Triangulation::NONE)
+            valid = at == expected;
+        CHECK(valid, "triangleAt (%s) (%g, %g) : %d au lieu de %d", stage, x, y, at, expected);
+    }
+}
+
+static void testSpatialQueries()
+{
+    std::mt19937 rng(7);
+    Triangulation diagram;
+    diagram.reset(0, 0, SIZE, SIZE);
+    for (const Site& s : randomSites(rng, 300))
+        diagram.insert(s);
+    checkSpatialQueries(diagram, rng, "insert");
+
+    // Gros lot : l'index est rechargé d'un coup
+    diagram.insertBatch(randomSites(rng, 2000));
+    checkSpatialQueries(diagram, rng, "insertBatch");
+
+    std::vector<Site> positions;
+    std::normal_distribution<double> jitter(0, 1);
+    for (int v = 3; v < diagram.vertexCount(); v++)
+    {
+        const Site& s = diagram.site(v);
+        positions.push_back(Site{std::clamp(s.x + jitter(rng), 0.0, SIZE), std::clamp(s.y + jitter(rng), 0.0, SIZE)});
+    }
+    diagram.moveSites(positions);
+    checkSpatialQueries(diagram, rng, "moveSites");
+    diagram.moveSites(randomSites(rng, (int)positions.size()));
+    checkSpatialQueries(diagram, rng, "moveSites (sauts)");
+}
+
+static void testLocator()
+{
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> coord(-50, SIZE + 50);
+    for (double maxWeight : {0.0, 400.0})
+    {
+        Triangulation diagram;
+        diagram.reset(0, 0, SIZE, SIZE);
+        diagram.insertBatch(randomSites(rng, 700, maxWeight));
+        SiteLocator locator;
+
+        std::vector<Site> queries;
+        for (int i = 0; i < 2000; i++)
+            queries.push_back(Site{coord(rng), coord(rng)});
+        std::vector<int> batch(queries.size());
+        locator.nearestSites(diagram, queries.data(), queries.size(), batch.data());
+
+        for (std::size_t i = 0; i < queries.size(); i++)
+        {
+            const Site& q = queries[i];
+            double best = INFINITY;
+            for (int v = 3; v < diagram.vertexCount(); v++)
+                best = std::min(best, power(diagram.site(v), q.x, q.y));
+            int found = locator.nearestSite(diagram, q.x, q.y);
+            double tolerance = 1e-9 * (1 + std::fabs(best));
+            CHECK(found >= 3 && power(diagram.site(found), q.x, q.y) <= best + tolerance,
+                "nearestSite (%g, %g) : sommet %d au lieu du plus proche", q.x, q.y, found);
+            CHECK(batch[i] >= 3 && power(diagram.site(batch[i]), q.x, q.y) <= best + tolerance,
+                "nearestSites (%g, %g) : sommet %d au lieu du plus proche", q.x, q.y, batch[i]);
+        }
+    }
+
+    Triangulation empty;
+    empty.reset(0, 0, SIZE, SIZE);
+    SiteLocator locator;
+    CHECK(locator.nearestSite(empty, 1, 1) == Triangulation::NONE, "nearestSite sans site");
+}
+
+static void testLloyd()
+{
+    std::mt19937 rng(8);
+    Triangulation diagram;
+    diagram.reset(0, 0, SIZE, SIZE);
+    diagram.insertBatch(randomSites(rng, 400));
+
+    LloydSettings settings;
+    settings.minX = settings.minY = 0;
+    settings.maxX = settings.maxY = SIZE;
+    settings.maxIterations = 1000;
+    settings.tolerance = 0.5;
+    int calls = 0;
+    settings.onIteration = [&](int, const LloydIteration&) { calls++; };
+    std::vector<LloydIteration> history = relaxLloyd(diagram, settings);
+
+    // L'énergie ne remonte pas, et la boucle s'arrête à la première itération sous la tolérance
+    CHECK(!history.empty() && (int)history.size() < settings.maxIterations, "relaxLloyd : %zu itérations", history.size());
+    CHECK(calls == (int)history.size(), "relaxLloyd : %d appels de onIteration", calls);
+    for (std::size_t i = 0; i < history.size(); i++)
+    {
+        if (i > 0)
+            CHECK(history[i].energy <= history[i - 1].energy * (1 + 1e-9),
+                "relaxLloyd : énergie %g après %g", history[i].energy, history[i - 1].energy);
+        if (i + 1 < history.size())
+            CHECK(history[i].maxDisplacement >= settings.tolerance, "relaxLloyd : pas arrêtée à l'itération %zu", i);
+    }
+    CHECK(history.empty() || history.back().maxDisplacement < settings.tolerance, "relaxLloyd : arrêtée avant la tolérance");
+    CHECK(diagram.siteCount() == 400 && isRegular(diagram), "relaxLloyd : diagramme incohérent");
+
+    // Annulée d'avance, aucune itération
+    std::atomic<bool> cancel{true};
+    settings.cancel = &cancel;
+    CHECK(relaxLloyd(diagram, settings).empty(), "relaxLloyd : annulation ignorée");
+}
+
+static void testSibsonLinearPrecision()
+{
+    std::mt19937 rng(6);
+    Triangulation diagram;
+    diagram.reset(0, 0, SIZE, SIZE);
+    std::vector<Site> sites = randomSites(rng, 1000);
+    for (const Site& s : sites)
+        diagram.insert(s);
+
+    // Une fonction affine est reproduite exactement. Près de l'enveloppe,
+    // les sommets du super triangle prennent part à la cavité : on reste au centre
+    auto linear = [](double x, double y) { return 2 + 3 * x - 0.5 * y; };
+    std::vector<double> values;
+    for (const Site& s : sites)
+        values.push_back(linear(s.x, s.y));
+
+    NaturalNeighbourInterpolator interpolator;
+    std::uniform_real_distribution<double> coord(SIZE / 4, 3 * SIZE / 4);
+    for (int i = 0; i < 2000; i++)
+    {
+        double x = coord(rng), y = coord(rng);
+        double expected = linear(x, y);
+        double value = interpolator.interpolate(diagram, values, x, y);
+        CHECK(std::fabs(value - expected) <= 1e-6 * (1 + std::fabs(expected)),
+            "interpolate (%g, %g) = %g au lieu de %g", x, y, value, expected);
+    }
+    for (const Site& s : sites)
+    {
+        if (s.x < SIZE / 4 || s.x > 3 * SIZE / 4 || s.y < SIZE / 4 || s.y > 3 * SIZE / 4)
+            continue;
+        double value = interpolator.interpolate(diagram, values, s.x, s.y);
+        CHECK(value == linear(s.x, s.y), "interpolate sur le site (%g, %g) = %g", s.x, s.y, value);
+    }
+    CHECK(std::isnan(interpolator.interpolate(diagram, values, -10, 500)), "interpolate hors de l'enveloppe");
+}
+
+static void testInterpolateGrid()
+{
+    std::mt19937 rng(9);
+    Triangulation diagram;
+    diagram.reset(0, 0, SIZE, SIZE);
+    std::vector<Site> sites = randomSites(rng, 500);
+    for (const Site& s : sites)
+        diagram.insert(s);
+    std::vector<double> values;
+    for (const Site& s : sites)
+        values.push_back(s.x * s.y / SIZE);
+
+    // Le cadre dépasse l'enveloppe des sites, comprise dans [0, SIZE]
+    const double minX = -200, minY = -100, maxX = SIZE + 200, maxY = SIZE + 100;
+    const int width = 70, height = 45;
+    std::vector<float> raster, single;
+    interpolateGrid(diagram, values, minX, minY, maxX, maxY, width, height, raster, 4);
+    interpolateGrid(diagram, values, minX, minY, maxX, maxY, width, height, single, 1);
+    CHECK(raster.size() == (std::size_t)width * height, "interpolateGrid : %zu valeurs", raster.size());
+
+    NaturalNeighbourInterpolator interpolator;
+    int inside = 0;
+    for (int j = 0; j < height && raster.size() == single.size(); j++)
+    {
+        for (int i = 0; i < width; i++)
+        {
+            double x = minX + (i + 0.5) * (maxX - minX) / width, y = minY + (j + 0.5) * (maxY - minY) / height;
+            float expected = (float)interpolator.interpolate(diagram, values, x, y);
+            float value = raster[(std::size_t)j * width + i];
+            bool same = std::isnan(expected) ? std::isnan(value) : std::fabs(value - expected) <= 1e-4f * (1 + std::fabs(expected));
+            CHECK(same, "interpolateGrid (%d, %d) = %g au lieu de %g", i, j, value, expected);
+            CHECK(std::isnan(value) == std::isnan(single[(std::size_t)j * width + i]),
+                "interpolateGrid (%d, %d) : dépend du nombre de threads", i, j);
+            if (x < 0 || y < 0 || x > SIZE || y > SIZE)
+                CHECK(std::isnan(value), "interpolateGrid (%g, %g) hors de l'enveloppe : %g", x, y, value);
+            inside += !std::isnan(value);
+        }
+    }
+    CHECK(inside > width * height / 3, "interpolateGrid : %d valeurs seulement", inside);
+}
+
+static void testWorkerPool()
+{
+    WorkerPool workers(4);
+    CHECK(workers.size() == 4, "WorkerPool : %u threads", workers.size());
+
+    // Chaque appel couvre [0, count) une seule fois, sur des threads réutilisés
+    for (int count : {0, 1, 3, 1000, 4097})
+    {
+        for (unsigned threads : {0u, 1u, 2u, 8u})
+        {
+            std::vector<int> seen(count, 0);
+            std::vector<unsigned> used(workers.size(), 0);
+            parallelFor(workers, count, [&](int begin, int end, unsigned worker) {
+                used[worker]++;
+                for (int i = begin; i < end; i++)
+                    seen[i]++;
+            }, threads);
+            CHECK(std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; }),
+                "parallelFor(%d, %u) : indices manqués ou répétés", count, threads);
+            CHECK(std::all_of(used.begin(), used.end(), [](unsigned n) { return n <= 1; }),
+                "parallelFor(%d, %u) : worker appelé deux fois", count, threads);
+        }
+    }
+}
+
+/* Compte les publications d'un DiagramWorker et attend un instantané voulu */
+class Publications
+{
+public:
+    explicit Publications(DiagramWorker& worker) : worker_(worker)
+    {
+        worker_.setNotify([this] {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sizes_.push_back(worker_.snapshot()->siteCount());
+            changed_.notify_all();
+        });
+    }
+
+    template <typename Predicate>
+    bool wait(Predicate done)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return changed_.wait_for(lock, std::chrono::seconds(60), [&] { return done(*worker_.snapshot()); });
+    }
+
+    std::vector<int> sizes()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sizes_;
+    }
+
+private:
+    DiagramWorker& worker_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<int> sizes_; // nombre de sites de chaque instantané publié
+};
+
+static void testDiagramWorker()
+{
+    std::mt19937 rng(10);
+
+    // Les insertions qui attendent derrière un gros lot n'en forment qu'un
+    {
+        DiagramWorker worker;
+        Publications published(worker);
+        worker.clear(0, 0, SIZE, SIZE);
+        worker.insert(randomSites(rng, 20000));
+        for (const Site& s : randomSites(rng, 200))
+            worker.insert({s});
+        bool done = published.wait([](const Triangulation& t) { return t.siteCount() == 20200; });
+        CHECK(done, "DiagramWorker : %d sites au lieu de 20200", worker.snapshot()->siteCount());
+        CHECK(published.sizes().size() < 20, "DiagramWorker : %zu publications, insertions non regroupées",
+            published.sizes().size());
+        worker.stop();
+    }
+
+    // Un vidage annule le lot en cours, qui n'est jamais publié
+    {
+        DiagramWorker worker;
+        Publications published(worker);
+        worker.clear(0, 0, SIZE, SIZE);
+        worker.insert(randomSites(rng, 50000));
+        worker.clear(0, 0, SIZE, SIZE);
+        worker.insert(randomSites(rng, 10));
+        bool done = published.wait([](const Triangulation& t) { return t.siteCount() == 10; });
+        CHECK(done, "DiagramWorker : vidage non suivi");
+        for (int n : published.sizes())
+            CHECK(n == 0 || n == 10, "DiagramWorker : instantané de %d sites après un vidage", n);
+        worker.stop();
+    }
+
+    // Une reconstruction annulée par la suivante ne laisse pas l'insertion
+    // intermédiaire dans l'ancien cadre, où ses sites seraient perdus
+    {
+        DiagramWorker worker;
+        Publications published(worker);
+        worker.clear(0, 0, SIZE, SIZE);
+        worker.insert(randomSites(rng, 30000));
+        published.wait([](const Triangulation& t) { return t.siteCount() == 30000; });
+
+        worker.rebuild(0, 0, 1e6, 1e6);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        std::vector<Site> far = randomSites(rng, 100);
+        for (Site& s : far)
+        {
+            s.x = 1e5 + s.x * 100;
+            s.y = 1e5 + s.y * 100;
+        }
+        worker.insert(far);
+        worker.rebuild(0, 0, 2e6, 2e6);
+        bool done = published.wait([](const Triangulation& t) { return t.siteCount() == 30100; });
+        CHECK(done, "DiagramWorker : %d sites après les reconstructions", worker.snapshot()->siteCount());
+        std::vector<int> sizes = published.sizes();
+        CHECK(std::count(sizes.begin(), sizes.end(), 30000) == 1,
+            "DiagramWorker : insertion publiée dans l'ancien cadre");
+        worker.stop();
+    }
+
+    // Relaxations consécutives regroupées, le diagramme reste complet
+    {
+        DiagramWorker worker;
+        Publications published(worker);
+        worker.clear(0, 0, SIZE, SIZE);
+        worker.insert(randomSites(rng, 2000));
+        LloydSettings settings;
+        settings.minX = settings.minY = 0;
+        settings.maxX = settings.maxY = SIZE;
+        settings.maxIterations = 3;
+        for (int i = 0; i < 50; i++)
+            worker.relax(settings);
+        worker.insert(randomSites(rng, 5));
+        bool done = published.wait([](const Triangulation& t) { return t.siteCount() == 2005; });
+        CHECK(done, "DiagramWorker : relaxation puis insertion perdues");
+        CHECK(published.sizes().size() < 50, "DiagramWorker : relaxations non regroupées");
+        worker.stop();
+    }
+}
+
+int main()
+{
+    testInsert();
+    testInsertBatch();
+    testMoveSites();
+    testSnapshot();
+    testSpatialQueries();
+    testLocator();
+    testLloyd();
+    testSibsonLinearPrecision();
+    testInterpolateGrid();
+    testWorkerPool();
+    testDiagramWorker();
+
+    if (failures)
+        std::printf("%d vérifications ratées\n", failures);
+    else
+        std::printf("tous les tests passent\n");
+    return failures ? 1 : 0;
+}